@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <robot_design/graph.h>
+#include <robot_design/optim.h>
+#include <robot_design/types.h>
+#include <robot_design/value.h>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace robot_design {
+
+// Evaluates a terminal design graph and returns its result; NaN marks an
+// invalid design (e.g. self-colliding or unstable), matching the None result
+// in the Python search loop. The seed makes repeated evaluations of the same
+// graph use independent optimizer noise
+using DesignEvaluator = std::function<Scalar(const Graph &, unsigned int)>;
+
+// Creates one evaluator per search worker, so evaluator state (simulation
+// instances, optimizer buffers) is never shared between threads
+using MakeDesignEvaluatorFunction = std::function<DesignEvaluator()>;
+
+using DesignResultCallback = std::function<void(
+    const Graph &, const std::vector<int> &rule_seq, Scalar result)>;
+
+// Per-action Monte Carlo and AMAF statistics, equivalent to the defaultdict
+// triples in mcts.py. pending_count_ is the virtual loss: selections in
+// flight on other threads, counted into the visit terms of the UCT score so
+// concurrent workers spread over different actions
+struct DesignActionStats {
+  int visit_count_ = 0;
+  Scalar result_sum_ = 0.0;
+  Scalar result_max_ = -std::numeric_limits<Scalar>::infinity();
+  int amaf_visit_count_ = 0;
+  Scalar amaf_result_sum_ = 0.0;
+  Scalar amaf_result_max_ = -std::numeric_limits<Scalar>::infinity();
+  int pending_count_ = 0;
+};
+
+// One search tree node, keyed by the graph's hash digest. Statistics are
+// guarded by the node's own mutex so updates on different nodes never
+// contend; the shared node map lock is only taken to look up or insert nodes
+struct DesignSearchNode {
+  explicit DesignSearchNode(const Graph &graph) : graph_(graph) {}
+
+  Graph graph_;
+  int visit_count_ = 0;
+  int pending_count_ = 0;
+  Scalar result_sum_ = 0.0;
+  Scalar result_max_ = -std::numeric_limits<Scalar>::infinity();
+  // Keyed by rule index
+  std::unordered_map<int, DesignActionStats> action_stats_;
+  bool blocked_ = false;
+  std::mutex mutex_;
+};
+
+// Monte Carlo tree search over design graphs, run natively across worker
+// threads. Selection and expansion use the graph rewriting machinery
+// (findMatches / checkRuleApplicability / applyRule) directly, states are
+// deduplicated by their hash digest as in the Python TreeSearch, and each
+// worker owns a private evaluator so candidate evaluations (typically MPPI
+// trajectory optimization) run fully in parallel. Python is only involved
+// in configuration and, optionally, a per-result callback
+class DesignSearch {
+public:
+  DesignSearch(const Graph &initial_graph, const std::vector<Rule> &rules,
+               int max_rule_seq_len, int max_tries, int thread_count,
+               unsigned int seed,
+               const MakeDesignEvaluatorFunction &make_evaluator_fn);
+
+  // Runs iteration_count search iterations across the worker threads,
+  // blocking until all have finished. May be called repeatedly; the tree
+  // persists between calls
+  void run(int iteration_count);
+
+  // Invoked after every completed evaluation with no search locks held, so
+  // the callback may safely block (e.g. reacquire the Python GIL) while
+  // other threads poll the getters. Callbacks may run concurrently on
+  // worker threads; set the callback before calling run()
+  void setResultCallback(const DesignResultCallback &callback);
+
+  int getNodeCount() const;
+  int getEvaluationCount() const;
+  Scalar getBestResult() const;
+  std::vector<int> getBestRuleSequence() const;
+
+private:
+  // One playout state: the graph, its hash key, and the rule sequence that
+  // produced it
+  struct SearchState {
+    Graph graph_;
+    std::size_t key_;
+    std::vector<int> rule_seq_;
+  };
+
+  using PendingMarks = std::vector<std::pair<DesignSearchNode *, int>>;
+
+  Scalar uctScore(const DesignSearchNode &node,
+                  const DesignActionStats &stats) const;
+  // Returns the chosen rule index and fills next_graph, or -1 if no action
+  // is available (terminal state, max depth, or all successors blocked).
+  // When the tree policy is followed, the virtual loss applied to the
+  // chosen action is recorded in pending_marks
+  int selectAction(const SearchState &state, std::mt19937 &rng,
+                   Graph &next_graph, PendingMarks &pending_marks);
+  DesignSearchNode *findNode(std::size_t key);
+  DesignSearchNode &findOrCreateNode(std::size_t key, const Graph &graph);
+  void runIteration(std::mt19937 &rng, const DesignEvaluator &evaluator);
+
+  std::vector<Rule> rules_;
+  int max_rule_seq_len_;
+  int max_tries_;
+  int thread_count_;
+  MakeDesignEvaluatorFunction make_evaluator_fn_;
+  SearchState initial_state_;
+
+  mutable std::shared_mutex nodes_mutex_;
+  std::unordered_map<std::size_t, std::unique_ptr<DesignSearchNode>> nodes_;
+
+  std::atomic<int> iterations_remaining_{0};
+  std::atomic<std::uint64_t> eval_seed_counter_;
+
+  mutable std::mutex result_mutex_;
+  // Guards result_callback_ itself; the callback is copied out and invoked
+  // with no locks held
+  std::mutex callback_mutex_;
+  DesignResultCallback result_callback_;
+  int eval_count_ = 0;
+  Scalar best_result_ = -std::numeric_limits<Scalar>::infinity();
+  std::vector<int> best_rule_seq_;
+};
+
+// Built-in evaluator running one trajectory optimization episode per design
+// with a private EpisodeRunner, equivalent to the single-episode simulate()
+// path in design_search.py. make_robot_sim_fn receives the design graph and
+// returns a simulation containing the robot and terrain (or nullptr to
+// reject the design, e.g. after a failed presimulation check); it is called
+// once per simulation instance during evaluator setup, so a Python callable
+// here only costs GIL acquisitions outside the optimization hot loop
+class MPPIDesignEvaluator {
+public:
+  using MakeRobotSimFunction =
+      std::function<std::shared_ptr<Simulation>(const Graph &)>;
+
+  MPPIDesignEvaluator(Scalar kappa, Scalar discount_factor, int interval,
+                      int horizon, int episode_len, int init_sample_count,
+                      int sample_count, int thread_count,
+                      const MakeRobotSimFunction &make_robot_sim_fn,
+                      const ObjectiveFunction &objective_fn,
+                      const std::shared_ptr<const InputSampler> &input_sampler);
+
+  // Returns the mean reward over the episode, or NaN if make_robot_sim_fn
+  // rejected the design
+  Scalar operator()(const Graph &graph, unsigned int seed) const;
+
+private:
+  Scalar kappa_;
+  Scalar discount_factor_;
+  int interval_;
+  int horizon_;
+  int episode_len_;
+  int init_sample_count_;
+  int sample_count_;
+  int thread_count_;
+  MakeRobotSimFunction make_robot_sim_fn_;
+  ObjectiveFunction objective_fn_;
+  std::shared_ptr<const InputSampler> input_sampler_;
+};
+
+} // namespace robot_design
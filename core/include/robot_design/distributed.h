@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <robot_design/optim.h>
+#include <robot_design/sim.h>
+#include <robot_design/types.h>
+#include <robot_design/value.h>
+#include <string>
+#include <vector>
+
+namespace robot_design {
+
+// Wire protocol for distributed rollout sampling. Rollouts are reproducible
+// from (seed, sample index) because input sampling is deterministic, so a
+// request carries only the packed simulation state, the current input
+// sequence and history, and a seed range; the response carries one return
+// and one final observation column per sample. Scalars are sent in host
+// byte order (all supported platforms are little-endian)
+struct RolloutRequestHeader {
+  std::uint32_t magic_;
+  std::uint32_t sample_seed_;
+  std::int32_t sample_start_;
+  std::int32_t sample_count_;
+  std::int32_t state_size_;
+  std::int32_t dof_count_;
+  std::int32_t horizon_;
+};
+
+struct RolloutResponseHeader {
+  std::uint32_t magic_;
+  std::int32_t sample_count_;
+  std::int32_t obs_size_;
+};
+
+constexpr std::uint32_t ROLLOUT_REQUEST_MAGIC = 0x524f4c31;  // "ROL1"
+constexpr std::uint32_t ROLLOUT_RESPONSE_MAGIC = 0x524f4c32; // "ROL2"
+
+// Coordinator-side connection to one rollout worker process. requestRollouts
+// returns as soon as the request is on the wire, so the coordinator can run
+// its local share of the samples while the worker simulates; collectResults
+// blocks until the worker's response arrives
+class RemoteRolloutClient {
+public:
+  RemoteRolloutClient(const std::string &host, int port, int sample_share);
+  ~RemoteRolloutClient();
+  RemoteRolloutClient(const RemoteRolloutClient &other) = delete;
+  RemoteRolloutClient &operator=(const RemoteRolloutClient &other) = delete;
+
+  // Number of samples this worker is assigned per update
+  int getSampleShare() const { return sample_share_; }
+
+  void requestRollouts(unsigned int sample_seed, int sample_start,
+                       int sample_count,
+                       const Ref<const VectorX> &packed_state,
+                       const Ref<const MatrixX> &input_sequence,
+                       const Ref<const MatrixX> &history);
+  // returns has sample_count entries and final_obs sample_count columns,
+  // matching the preceding request
+  void collectResults(Ref<VectorX> returns, Ref<MatrixX> final_obs);
+
+private:
+  int fd_ = -1;
+  int sample_share_;
+};
+
+// Worker-side server: owns a pool of identically constructed simulation
+// instances and answers rollout requests from one coordinator at a time.
+// The interval, discount factor, objective, input sampler, and simulation
+// construction must match the coordinator's MPPIOptimizer; the value
+// estimator is only used to extract final observations. Simulation
+// instances require BulletSimulation (for the packed state path) and are
+// created lazily up to the largest requested sample count
+class RolloutWorkerServer {
+public:
+  RolloutWorkerServer(
+      int port, Scalar discount_factor, int interval, int thread_count,
+      const MakeSimFunction &make_sim_fn, const ObjectiveFunction &objective_fn,
+      const std::shared_ptr<const ValueEstimator> &value_estimator,
+      const std::shared_ptr<const InputSampler> &input_sampler);
+  ~RolloutWorkerServer();
+  RolloutWorkerServer(const RolloutWorkerServer &other) = delete;
+  RolloutWorkerServer &operator=(const RolloutWorkerServer &other) = delete;
+
+  // Accepts coordinator connections forever, one at a time
+  void serve();
+  // Serves a single coordinator connection, then returns
+  void serveOnce();
+
+private:
+  void handleConnection(int fd);
+  void ensureSimInstances(int count);
+
+  Scalar discount_factor_;
+  int interval_;
+  MakeSimFunction make_sim_fn_;
+  ObjectiveFunction objective_fn_;
+  std::shared_ptr<const ValueEstimator> value_estimator_;
+  std::shared_ptr<const InputSampler> input_sampler_;
+  std::vector<std::shared_ptr<BulletSimulation>> sim_instances_;
+  RolloutExecutor rollout_executor_;
+  int listen_fd_ = -1;
+};
+
+} // namespace robot_design
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <memory>
+#include <robot_design/optim.h>
+#include <robot_design/sim.h>
+#include <robot_design/types.h>
+#include <robot_design/value.h>
+
+namespace robot_design {
+
+using Eigen::Ref;
+
+// Runs an entire trajectory optimization episode natively: one construction
+// plus one run() call per candidate design. All simulation instances are
+// created up front by make_sim_fn, so run() never calls back into the
+// caller; the Python bindings release the GIL for the whole episode
+class EpisodeRunner {
+public:
+  // Mirrors the MPPIOptimizer constructor; the optimizer starts with
+  // init_sample_count samples for the warm-start update and drops to
+  // sample_count for the per-step updates
+  EpisodeRunner(Scalar kappa, Scalar discount_factor, int dof_count,
+                int interval, int horizon, int episode_len,
+                int init_sample_count, int sample_count, int thread_count,
+                unsigned int seed, const MakeSimFunction &make_sim_fn,
+                const ObjectiveFunction &objective_fn,
+                const std::shared_ptr<const ValueEstimator> &value_estimator,
+                const std::shared_ptr<const InputSampler> &input_sampler);
+  // Runs the episode, filling the caller-owned buffers: input_sequence is
+  // (dof_count x episode_len), rewards has episode_len * interval entries,
+  // and obs is (observation size x episode_len + 1). Returns the mean
+  // reward. Unlike the Python episode loop, no per-step noise is injected
+  Scalar run(Ref<MatrixX> input_sequence, Ref<VectorX> rewards,
+             Ref<MatrixX> obs);
+
+private:
+  int interval_;
+  int episode_len_;
+  int sample_count_;
+  ObjectiveFunction objective_fn_;
+  std::shared_ptr<const ValueEstimator> value_estimator_;
+  std::shared_ptr<Simulation> main_sim_;
+  MPPIOptimizer optimizer_;
+};
+
+} // namespace robot_design
@@ -3,11 +3,43 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <robot_design/render.h>
 
 namespace robot_design {
 
+// Applies control inputs and steps the simulation once; called on the
+// simulation thread by GLFWViewer::run
+using SimStepCallback = std::function<void(int step_idx)>;
+
+// Triple-buffered snapshot exchange between one simulation thread (the
+// writer) and one render thread (the reader); both sides are wait-free.
+// Slots hold the two most recent snapshots so the reader can interpolate
+class SimulationSnapshotBuffer {
+public:
+  void publish(const SimulationSnapshot &prev, const SimulationSnapshot &curr);
+  // Switches to the most recently published snapshot pair; returns false
+  // until the first publish
+  bool fetchLatest(const SimulationSnapshot *&prev,
+                   const SimulationSnapshot *&curr);
+
+private:
+  struct Slot {
+    SimulationSnapshot prev_;
+    SimulationSnapshot curr_;
+  };
+  std::array<Slot, 3> slots_;
+  // write_slot_ and read_slot_ are owned by their respective threads; the
+  // third slot is exchanged through ready_slot_
+  int write_slot_ = 0;
+  int read_slot_ = 1;
+  bool read_valid_ = false;
+  std::atomic<int> ready_slot_{2};
+  std::atomic<bool> fresh_{false};
+};
+
 class FPSCameraController {
 public:
   FPSCameraController(float move_speed = 2.0f, float mouse_sensitivity = 0.005f,
@@ -58,6 +90,13 @@ public:
                       unsigned char *pixels = nullptr) override;
   virtual void getFramebufferSize(int &width, int &height) const override;
   virtual void setFramebufferSize(int width, int height) override;
+  // Steps the simulation on a dedicated fixed-timestep thread while the
+  // calling thread renders interpolated snapshots, so a slow frame never
+  // stalls the physics and vice versa. step_callback runs on the simulation
+  // thread; input handling and camera updates stay on the calling (render)
+  // thread, which must own the GL context. Returns when the window closes
+  void run(Simulation &sim, const SimStepCallback &step_callback,
+           double real_time_factor = 1.0);
   bool shouldClose() const;
   static void errorCallback(int error, const char *description);
   static void keyCallback(GLFWwindow *window, int key, int scancode, int action,
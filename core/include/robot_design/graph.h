@@ -3,12 +3,16 @@
 #include <Eigen/Dense>
 #include <cstddef>
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <robot_design/eigen_hash.h>
 #include <robot_design/robot.h>
 #include <robot_design/utils.h>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -121,6 +125,36 @@ struct Graph {
   std::vector<Node> nodes_;
   std::vector<Edge> edges_;
   std::vector<Subgraph> subgraphs_;
+
+  // Cached hash digest filled in lazily by hashGraph(); mutable so the cache
+  // works on const graphs, which are the common case during search
+  mutable std::size_t cached_hash_ = 0;
+  mutable bool cached_hash_valid_ = false;
+};
+
+// Returns the graph's order-independent hash digest, computing it in a
+// single pass over the nodes and edges and caching it on the graph. Call
+// invalidateGraphHash after mutating a graph's nodes or edges directly
+std::size_t hashGraph(const Graph &graph);
+
+inline void invalidateGraphHash(const Graph &graph) {
+  graph.cached_hash_valid_ = false;
+}
+
+// Precomputed adjacency lists and label buckets for a Graph, so matching can
+// answer neighborhood and label queries without scanning the edge vector.
+// Build it once per graph and pass it to findMatches when matching several
+// patterns against the same target
+struct GraphIndex {
+  GraphIndex() = default;
+  explicit GraphIndex(const Graph &graph);
+
+  // Edges with the given node as their tail (edges point tail -> head)
+  std::vector<std::vector<EdgeIndex>> out_edges_;
+  // Edges with the given node as their head
+  std::vector<std::vector<EdgeIndex>> in_edges_;
+  // Node indices (in increasing order) for each node label
+  std::unordered_map<std::string, std::vector<NodeIndex>> nodes_by_label_;
 };
 
 struct GraphMapping {
@@ -139,8 +173,72 @@ struct Rule {
   GraphMapping common_to_rhs_;
 };
 
+// Parses graphs from a .dot file; a binary sidecar cache (path + "c") is
+// loaded instead when it is at least as new as the source file, and is
+// refreshed after a successful parse
 std::vector<Graph> loadGraphs(const std::string &path);
 
+// Writes/reads graphs in a flat, versioned, little-endian binary layout
+// which loads with a single bulk file read
+void saveGraphsBinary(const std::vector<Graph> &graphs,
+                      const std::string &path);
+
+std::vector<Graph> loadGraphsBinary(const std::string &path);
+
+// Interned DOT attribute keys; applying an attribute is a switch on the
+// enum instead of a chain of string compares
+enum class NodeAttributeKey : int {
+  UNKNOWN,
+  LABEL,
+  SHAPE,
+  LENGTH,
+  RADIUS,
+  DENSITY,
+  FRICTION,
+  BASE,
+  COLOR,
+  REQUIRE_LABEL
+};
+
+enum class EdgeAttributeKey : int {
+  UNKNOWN,
+  ID,
+  LABEL,
+  TYPE,
+  OFFSET,
+  AXIS_ANGLE,
+  JOINT_AXIS,
+  KP,
+  KD,
+  TORQUE,
+  LIMITS,
+  CONTROL_MODE,
+  SCALE,
+  MIRROR,
+  COLOR,
+  REQUIRE_LABEL
+};
+
+// One parsed DOT attribute; the key is resolved against both attribute
+// namespaces when the attribute list is built, since the same a_list
+// grammar feeds node and edge statements
+struct DotAttribute {
+  NodeAttributeKey node_key_;
+  EdgeAttributeKey edge_key_;
+  std::string value_;
+};
+
+NodeAttributeKey lookupNodeAttributeKey(const std::string &key);
+
+EdgeAttributeKey lookupEdgeAttributeKey(const std::string &key);
+
+void updateNodeAttributes(NodeAttributes &node_attrs,
+                          const std::vector<DotAttribute> &attr_list);
+
+void updateEdgeAttributes(EdgeAttributes &edge_attrs,
+                          const std::vector<DotAttribute> &attr_list);
+
+// Convenience overloads which intern the keys on the fly
 void updateNodeAttributes(
     NodeAttributes &node_attrs,
     const std::vector<std::pair<std::string, std::string>> &attr_list);
@@ -157,17 +255,54 @@ std::ostream &operator<<(std::ostream &out, const Graph &graph);
 
 Robot buildRobot(const Graph &graph);
 
+// Thread-safe LRU cache from graph hash digests to built robots; buildRobot
+// output depends only on the graph, so revisited designs share one Robot
+// instance instead of being rebuilt
+class RobotCache {
+public:
+  using Entry = std::pair<std::size_t, std::shared_ptr<const Robot>>;
+
+  explicit RobotCache(std::size_t capacity = 256);
+  std::shared_ptr<const Robot> get(const Graph &graph);
+
+private:
+  std::size_t capacity_;
+  std::mutex mutex_;
+  // Most recently used entries are at the front
+  std::list<Entry> entries_;
+  std::unordered_map<std::size_t, std::list<Entry>::iterator> lookup_;
+};
+
+// Builds robots through a process-wide shared RobotCache
+std::shared_ptr<const Robot> buildRobotCached(const Graph &graph);
+
 Rule createRuleFromGraph(const Graph &graph);
 
 std::vector<GraphMapping> findMatches(const Graph &pattern,
                                       const Graph &target);
 
+std::vector<GraphMapping> findMatches(const Graph &pattern,
+                                      const Graph &target,
+                                      const GraphIndex &target_index);
+
 bool checkRuleApplicability(const Rule &rule, const Graph &target,
                             const GraphMapping &lhs_to_target);
 
 Graph applyRule(const Rule &rule, const Graph &target,
                 const GraphMapping &lhs_to_target);
 
+// Variant of applyRule which writes into a caller-provided graph, reusing
+// its node/edge storage across calls; result may not alias target
+void applyRuleInto(const Rule &rule, const Graph &target,
+                   const GraphMapping &lhs_to_target, Graph &result);
+
+// Applies every applicable (rule, match) combination to the graph across a
+// thread pool and returns the successor graphs, deduplicated by their hash
+// digest; thread_count <= 0 uses the hardware concurrency
+std::vector<Graph> expandGraph(const Graph &graph,
+                               const std::vector<Rule> &rules,
+                               int thread_count = 0);
+
 /**
  * Copy attributes that are different from their default values from src to
  * dest.
@@ -213,50 +348,7 @@ template <> struct hash<robot_design::EdgeAttributes> {
 
 template <> struct hash<robot_design::Graph> {
   std::size_t operator()(const robot_design::Graph &graph) const {
-    using robot_design::Edge;
-    using robot_design::EdgeAttributes;
-    using robot_design::EdgeIndex;
-    using robot_design::hashCombine;
-    using robot_design::Node;
-    using robot_design::NodeIndex;
-    using robot_design::Subgraph;
-
-    std::size_t seed = 0;
-    hashCombine(seed, graph.name_);
-
-    // Hash nodes (order should not matter)
-    std::size_t nodes_seed = 0;
-    for (std::size_t i = 0; i < graph.nodes_.size(); ++i) {
-      const Node &node = graph.nodes_[i];
-      std::size_t node_seed = std::hash<Node>()(node);
-      std::size_t head_node_seed = 0;
-      std::size_t tail_node_seed = 0;
-      for (const Edge &edge : graph.edges_) {
-        if (edge.head_ == i) {
-          head_node_seed += std::hash<EdgeAttributes>()(edge.attrs_);
-        }
-        if (edge.tail_ == i) {
-          tail_node_seed += std::hash<EdgeAttributes>()(edge.attrs_);
-        }
-      }
-      hashCombine(node_seed, head_node_seed);
-      hashCombine(node_seed, tail_node_seed);
-      nodes_seed += node_seed;
-    }
-    hashCombine(seed, nodes_seed);
-
-    // Hash edges (order should not matter)
-    std::size_t edges_seed = 0;
-    for (const Edge &edge : graph.edges_) {
-      std::size_t edge_seed = 0;
-      hashCombine(edge_seed, graph.nodes_[edge.head_]);
-      hashCombine(edge_seed, graph.nodes_[edge.tail_]);
-      hashCombine(edge_seed, edge.attrs_);
-      edges_seed += edge_seed;
-    }
-    hashCombine(seed, edges_seed);
-
-    return seed;
+    return robot_design::hashGraph(graph);
   }
 };
 
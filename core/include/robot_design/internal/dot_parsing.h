@@ -35,8 +35,8 @@ struct State {
   SubgraphIndex latest_subgraph_index_;
   // Index of the most recently referenced node
   NodeIndex latest_node_index_;
-  // Most recent attribute list
-  std::vector<std::pair<std::string, std::string>> attr_list_;
+  // Most recent attribute list, with keys interned as they are parsed
+  std::vector<DotAttribute> attr_list_;
   // Most recent attribute key
   std::string attr_key_;
   // Most recent attribute value
@@ -273,8 +273,12 @@ template <> struct dot_action<dot_rules::a_list_value> {
 
 template <> struct dot_action<dot_rules::a_list_item> {
   static void apply0(State &state) {
-    state.attr_list_.emplace_back(std::move(state.attr_key_),
-                                  std::move(state.attr_value_));
+    // Intern the key against both attribute namespaces now, so applying
+    // the list later involves no string compares
+    state.attr_list_.push_back(
+        {/*node_key=*/lookupNodeAttributeKey(state.attr_key_),
+         /*edge_key=*/lookupEdgeAttributeKey(state.attr_key_),
+         /*value=*/std::move(state.attr_value_)});
   }
 };
 
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <robot_design/render.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace robot_design {
+
+// Receives finished frames on the worker thread; pixels are tightly packed
+// RGBA rows, bottom-up as returned by glReadPixels
+using FrameCallback = std::function<void(
+    int frame_idx, int width, int height, const unsigned char *pixels)>;
+
+// Renders GLRenderer scenes into an offscreen framebuffer without a visible
+// window, for batch rendering on display-less machines. Frames are read
+// back through a ring of pixel buffer objects so the copy overlaps
+// rendering of the following frames, and finished frames are handed to a
+// FrameCallback (e.g. a video encoder or writeFramePNG) on a worker thread.
+// GLFW still provides the GL context, via an invisible window
+class OffscreenRenderer : public Viewer {
+public:
+  OffscreenRenderer(int width, int height, int pbo_count = 3);
+  virtual ~OffscreenRenderer();
+  OffscreenRenderer(const OffscreenRenderer &other) = delete;
+  OffscreenRenderer &operator=(const OffscreenRenderer &other) = delete;
+  virtual void update(double dt) override {}
+  // With a frame callback set and pixels == nullptr, readback is
+  // asynchronous through the PBO ring; passing a pixel buffer forces a
+  // synchronous read instead
+  virtual void render(const Simulation &sim,
+                      unsigned char *pixels = nullptr) override;
+  virtual void getFramebufferSize(int &width, int &height) const override;
+  virtual void setFramebufferSize(int width, int height) override;
+  void setFrameCallback(const FrameCallback &frame_callback);
+  // Completes all in-flight readbacks and blocks until the worker thread
+  // has consumed every queued frame
+  void finish();
+  static void writeFramePNG(const std::string &path, int width, int height,
+                            const unsigned char *pixels);
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+  CameraParameters camera_params_;
+  RenderParameters render_params_;
+
+private:
+  struct QueuedFrame {
+    int frame_idx_;
+    std::vector<unsigned char> pixels_;
+  };
+
+  void createFramebuffer();
+  void createPixelBuffers();
+  // Maps the slot's PBO, copies the finished frame, and queues it for the
+  // worker thread
+  void completeReadback(int slot);
+  void workerLoop();
+
+  int width_;
+  int height_;
+  int pbo_count_;
+  int frame_count_ = 0;
+  GLFWwindow *window_ = nullptr;
+  std::shared_ptr<GLRenderer> renderer_;
+  std::shared_ptr<Framebuffer> framebuffer_;
+  std::shared_ptr<Texture2D> color_texture_;
+  std::shared_ptr<Texture2D> depth_texture_;
+  std::vector<GLuint> pixel_buffers_;
+  // Frame index pending in each PBO slot, or -1 if the slot is free
+  std::vector<int> pending_frame_idx_;
+  FrameCallback frame_callback_;
+  std::thread worker_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<QueuedFrame> frame_queue_;
+  std::size_t max_queue_size_ = 8;
+  bool shutdown_ = false;
+};
+
+} // namespace robot_design
@@ -1,14 +1,24 @@
 #pragma once
 
-#include <ThreadPool.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <mutex>
 #include <robot_design/robot.h>
 #include <robot_design/sim.h>
 #include <robot_design/types.h>
 #include <robot_design/value.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace robot_design {
 
+class RemoteRolloutClient;
+struct SumOfSquaresObjective;
+struct DotProductObjective;
+
 using MakeSimFunction = std::function<std::shared_ptr<Simulation>()>;
 
 using ObjectiveFunction = std::function<Scalar(const Simulation &)>;
@@ -38,6 +48,24 @@ public:
   Scalar warm_start_std_dev_;
 };
 
+// Samples the same distribution as DefaultInputSampler, but uses a
+// counter-based generator (SplitMix64) so the noise matrix is filled in
+// vectorizable blocks with no per-call generator warm-up, and applies the
+// smoothing FIR filter as a single banded matrix product
+class VectorizedInputSampler : public InputSampler {
+public:
+  VectorizedInputSampler(Scalar history_std_dev = 0.05,
+                         Scalar warm_start_std_dev = 0.25);
+  virtual ~VectorizedInputSampler() {}
+  virtual void
+  sampleInputSequence(Ref<MatrixX> input_seq, unsigned int sample_seed,
+                      int sample_idx, const Ref<const MatrixX> &last_input_seq,
+                      const Ref<const MatrixX> &history) const override;
+
+  Scalar history_std_dev_;
+  Scalar warm_start_std_dev_;
+};
+
 class ConstantInputSampler : public InputSampler {
 public:
   ConstantInputSampler() {}
@@ -50,6 +78,35 @@ public:
   MatrixX samples_;
 };
 
+// Persistent worker threads which run one task function over a range of
+// sample indices per invocation; samples are claimed through a shared atomic
+// counter and completion is signaled once per invocation, so the hot loop
+// performs no per-task allocation and takes no queue lock
+class RolloutExecutor {
+public:
+  explicit RolloutExecutor(int thread_count);
+  ~RolloutExecutor();
+  RolloutExecutor(const RolloutExecutor &other) = delete;
+  RolloutExecutor &operator=(const RolloutExecutor &other) = delete;
+  // Runs task_fn(idx) for every idx in [0, count), blocking until all
+  // indices have been processed
+  void run(int count, const std::function<void(int)> &task_fn);
+
+private:
+  void workerLoop();
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(int)> *task_fn_ = nullptr;
+  int task_count_ = 0;
+  std::atomic<int> next_idx_{0};
+  std::atomic<int> remaining_{0};
+  std::uint64_t generation_ = 0;
+  bool shutdown_ = false;
+};
+
 class MPPIOptimizer {
 public:
   MPPIOptimizer(Scalar kappa, Scalar discount_factor, int dof_count,
@@ -62,11 +119,37 @@ public:
   void advance(int step_count);
   int getSampleCount() const;
   void setSampleCount(int sample_count);
+  // Abort rollouts whose partial return falls more than margin / kappa below
+  // the best partial return seen at the same horizon checkpoint; pruned
+  // samples keep their partial return, whose weight is at most exp(-margin).
+  // Disabled by default so the exact MPPI weighting is preserved
+  void setRolloutPruning(bool enabled, Scalar margin = 5.0);
+  // Overlap value estimation with simulation: completed rollouts are handed
+  // to the value estimator in chunks while the remaining rollouts still run,
+  // so update latency approaches max(sim time, inference time) instead of
+  // their sum. chunk_count is the number of estimator calls per update
+  void setPipelinedValueEstimation(bool enabled, int chunk_count = 8);
+  // Connects to a RolloutWorkerServer which will simulate sample_share of
+  // each update's samples; shares are taken from the tail of the sample
+  // range and the rest runs locally. The worker must be configured with the
+  // same simulation setup, objective, input sampler, and interval. Rollout
+  // pruning and pipelined value estimation only apply to the local share
+  void addRemoteWorker(const std::string &host, int port, int sample_share);
+  // Zero-copy views over internal state, exposed to Python without copying.
+  // input_sequence_ and history_ are never reallocated after construction;
+  // views of final_obs_ are invalidated by setSampleCount
+  Eigen::Ref<MatrixX> getHistory() { return history_; }
+  Eigen::Ref<MatrixX> getFinalObs() { return final_obs_; }
 
   MatrixX input_sequence_;
 
 private:
   Scalar runSimulation(unsigned int sample_seed, int sample_idx);
+  // Rollout loop templated on the objective evaluation callable, so that
+  // statically known objectives are inlined into the inner loop
+  template <typename EvalFn>
+  Scalar runSimulationImpl(unsigned int sample_seed, int sample_idx,
+                           const EvalFn &eval_fn);
   void advanceSimulation(int sample_idx, int step_count);
 
   Scalar kappa_;
@@ -80,14 +163,35 @@ private:
   std::shared_ptr<const ValueEstimator> value_estimator_;
   std::shared_ptr<const InputSampler> input_sampler_;
   std::vector<std::shared_ptr<Simulation>> sim_instances_;
+  // Input sequences sampled by the workers, one flattened (dof_count x
+  // horizon) sequence per column; update() reuses these directly instead of
+  // re-running the sampler
+  MatrixX sample_input_seqs_;
   MatrixX final_obs_;
   MatrixX history_;
   int total_step_count_;
-  ThreadPool thread_pool_;
+  RolloutExecutor rollout_executor_;
+  bool rollout_pruning_ = false;
+  Scalar pruning_margin_ = 5.0;
+  // Best partial return published by any worker at each horizon checkpoint
+  std::vector<std::atomic<Scalar>> checkpoint_best_;
+  bool pipelined_value_est_ = false;
+  int value_est_chunk_count_ = 8;
+  std::vector<std::shared_ptr<RemoteRolloutClient>> remote_workers_;
+  // Set when objective_fn_ wraps a statically known objective type;
+  // runSimulation then dispatches to a rollout with the reward computation
+  // inlined instead of calling through the std::function every step
+  const SumOfSquaresObjective *sos_objective_ = nullptr;
+  const DotProductObjective *dot_objective_ = nullptr;
+  // Per-sample scratch buffers for the specialized objectives' state reads
+  std::vector<VectorX> objective_state_buffers_;
 };
 
 struct SumOfSquaresObjective {
   Scalar operator()(const Simulation &sim) const;
+  // Buffer-reusing variant; state is resized as needed and keeps its
+  // allocation across calls
+  Scalar operator()(const Simulation &sim, VectorX &state) const;
 
   Vector6 base_vel_ref_ = Vector6::Zero();
   Vector6 base_vel_weight_ = Vector6::Zero();
@@ -96,6 +200,9 @@ struct SumOfSquaresObjective {
 
 struct DotProductObjective {
   Scalar operator()(const Simulation &sim) const;
+  // Buffer-reusing variant; state is resized as needed and keeps its
+  // allocation across calls
+  Scalar operator()(const Simulation &sim, VectorX &state) const;
 
   Vector3 base_dir_weight_ = Vector3::Zero();
   Vector3 base_up_weight_ = Vector3::Zero();
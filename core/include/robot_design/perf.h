@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace robot_design {
+
+// Instrumented hot-path phases. Timers accumulate into thread-local state
+// (no locks or shared cache lines on the hot path) and are aggregated
+// across threads when getPerfStats() is called. Compile with
+// -DROBOT_DESIGN_DISABLE_PROFILING to remove the instrumentation entirely
+enum class PerfPhase : int {
+  MPPI_SAMPLING = 0,
+  MPPI_STEPPING,
+  MPPI_OBJECTIVE,
+  MPPI_VALUE_ESTIMATION,
+  MPPI_WEIGHTING,
+  SIM_STEP,
+  GRAPH_FIND_MATCHES,
+  GRAPH_APPLY_RULE,
+};
+
+constexpr int PERF_PHASE_COUNT = 8;
+
+// Aggregated statistics for one phase. Counts and totals cover every event
+// since the last reset; the percentiles and max are computed over the most
+// recent events (a bounded ring per thread), which is what tail latency
+// monitoring wants
+struct PerfPhaseStats {
+  std::uint64_t count_ = 0;
+  std::uint64_t total_ns_ = 0;
+  std::uint64_t p50_ns_ = 0;
+  std::uint64_t p90_ns_ = 0;
+  std::uint64_t p99_ns_ = 0;
+  std::uint64_t max_ns_ = 0;
+};
+
+const char *getPerfPhaseName(PerfPhase phase);
+
+std::array<PerfPhaseStats, PERF_PHASE_COUNT> getPerfStats();
+
+// Zeroes all statistics; call between measurement windows, not while
+// instrumented code is running on other threads
+void resetPerfStats();
+
+#if !defined(ROBOT_DESIGN_DISABLE_PROFILING)
+
+namespace perf_internal {
+
+// Recent samples kept per phase per thread for percentile estimation
+constexpr std::size_t PERF_SAMPLE_RING_SIZE = 1024;
+
+// Writers touch only their own thread's accumulator; readers aggregate with
+// relaxed loads, so a read concurrent with recording is approximate but
+// never tears or blocks the hot path
+struct PhaseAccum {
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> total_ns_{0};
+  std::array<std::atomic<std::uint64_t>, PERF_SAMPLE_RING_SIZE> samples_{};
+};
+
+void recordSample(PerfPhase phase, std::uint64_t duration_ns);
+
+} // namespace perf_internal
+
+// Scoped timer recording the nanoseconds between construction and
+// destruction against the given phase
+class PerfScope {
+public:
+  explicit PerfScope(PerfPhase phase)
+      : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+  ~PerfScope() {
+    auto duration = std::chrono::steady_clock::now() - start_;
+    perf_internal::recordSample(
+        phase_, static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        duration)
+                        .count()));
+  }
+  PerfScope(const PerfScope &other) = delete;
+  PerfScope &operator=(const PerfScope &other) = delete;
+
+private:
+  PerfPhase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#define RD_PERF_CONCAT_IMPL(a, b) a##b
+#define RD_PERF_CONCAT(a, b) RD_PERF_CONCAT_IMPL(a, b)
+#define RD_PERF_SCOPE(phase)                                                   \
+  ::robot_design::PerfScope RD_PERF_CONCAT(rd_perf_scope_, __LINE__)(phase)
+
+#else
+
+class PerfScope {
+public:
+  explicit PerfScope(PerfPhase) {}
+};
+
+#define RD_PERF_SCOPE(phase) ((void)0)
+
+#endif
+
+} // namespace robot_design
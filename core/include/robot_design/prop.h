@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <robot_design/types.h>
+#include <string>
 
 namespace robot_design {
 
-enum class PropShape : Index { BOX, HEIGHTFIELD };
+enum class PropShape : Index { BOX, HEIGHTFIELD, TILED_HEIGHTFIELD };
 
 struct Prop {
   Prop() = default;
@@ -39,4 +41,44 @@ struct HeightfieldProp : Prop {
   MatrixX heightfield_;
 };
 
+// Heightfield split into fixed-size tiles which the simulation instantiates
+// lazily around active robots; each tile becomes a separate static collision
+// object with its own broadphase AABB, so collision queries never touch
+// distant terrain. Heights cover the same [0, 1] range and sample layout as
+// HeightfieldProp (rows along x, columns along z, column-major). The
+// memory-mapped constructor keeps far terrain on disk: pages are only
+// faulted in when a tile near a robot is instantiated
+struct TiledHeightfieldProp : Prop {
+  TiledHeightfieldProp(Scalar friction, const Vector3 &half_extents,
+                       MatrixX heightfield, int tile_size = 64);
+  // Maps a file containing rows x cols column-major Scalar heights read-only
+  TiledHeightfieldProp(Scalar friction, const Vector3 &half_extents,
+                       const std::string &path, Index rows, Index cols,
+                       int tile_size = 64);
+  virtual ~TiledHeightfieldProp();
+  TiledHeightfieldProp(const TiledHeightfieldProp &other) = delete;
+  TiledHeightfieldProp &operator=(const TiledHeightfieldProp &other) = delete;
+
+  Index rows() const { return rows_; }
+  Index cols() const { return cols_; }
+  Scalar height(Index row, Index col) const {
+    return data_[col * rows_ + row];
+  }
+
+  // Samples per tile edge; adjacent tiles share one sample row/column so
+  // the collision surface is seamless
+  int tile_size_;
+
+private:
+  Index rows_ = 0;
+  Index cols_ = 0;
+  // Points into heightfield_ or into the mapped region
+  const Scalar *data_ = nullptr;
+  // Owns the height data in the in-memory case
+  MatrixX heightfield_;
+  void *mapped_addr_ = nullptr;
+  std::size_t mapped_size_ = 0;
+  int fd_ = -1;
+};
+
 } // namespace robot_design
@@ -4,9 +4,11 @@
 #include <GL/glew.h>
 #include <array>
 #include <cmath>
+#include <map>
 #include <memory>
 #include <robot_design/sim.h>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -24,6 +26,12 @@ struct VertexAttribute {
 extern const VertexAttribute ATTRIB_POSITION;
 extern const VertexAttribute ATTRIB_NORMAL;
 extern const VertexAttribute ATTRIB_TEX_COORD;
+// Per-instance attributes for instanced drawing; the mat4 attributes occupy
+// four consecutive indices each
+extern const VertexAttribute ATTRIB_INSTANCE_MODEL_MATRIX;
+extern const VertexAttribute ATTRIB_INSTANCE_TEX_COORDS_MATRIX;
+extern const VertexAttribute ATTRIB_INSTANCE_COLOR;
+extern const VertexAttribute ATTRIB_INSTANCE_PROC_TEXTURE_TYPE;
 
 struct DirectionalLight;
 
@@ -113,6 +121,10 @@ struct Mesh {
   void draw() const {
     glDrawElements(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, 0);
   }
+  void drawInstanced(GLsizei instance_count) const {
+    glDrawElementsInstanced(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, 0,
+                            instance_count);
+  }
 
   GLenum usage_;
   GLuint vertex_array_;
@@ -123,6 +135,29 @@ struct Mesh {
   GLsizei index_count_;
 };
 
+// One instance's attribute block, laid out as raw floats so a whole vector
+// of instances can be streamed directly into a vertex buffer
+struct MeshInstance {
+  std::array<GLfloat, 16> model_matrix_;
+  std::array<GLfloat, 16> tex_coords_matrix_;
+  std::array<GLfloat, 3> color_;
+  GLfloat proc_texture_type_;
+};
+
+// Persistent vertex buffer holding per-instance attributes, re-streamed each
+// frame; bindToMesh records the attribute layout into a mesh's vertex array
+// so the mesh can be drawn with Mesh::drawInstanced
+struct InstanceBuffer {
+  InstanceBuffer();
+  virtual ~InstanceBuffer();
+  InstanceBuffer(const InstanceBuffer &other) = delete;
+  InstanceBuffer &operator=(const InstanceBuffer &other) = delete;
+  void bindToMesh(const Mesh &mesh) const;
+  void setData(const std::vector<MeshInstance> &instances);
+
+  GLuint buffer_;
+};
+
 struct Texture2D {
   Texture2D(GLenum target, GLint level, GLint internal_format, GLsizei width,
             GLsizei height, GLenum format, GLenum type,
@@ -295,50 +330,125 @@ struct ProgramState {
   ProgramParameter<Eigen::VectorXf> dir_light_sm_cascade_splits_;
 };
 
+// Everything the renderer needs from a Simulation, captured at one instant;
+// rendering from snapshots lets the simulation advance on another thread.
+// Rotations and translations are stored separately so two snapshots can be
+// interpolated
+struct SimulationSnapshot {
+  struct Transform {
+    Eigen::Matrix4f matrix() const {
+      return (Eigen::Translation3f(pos_) * rot_).matrix();
+    }
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    Eigen::Quaternionf rot_ = Eigen::Quaternionf::Identity();
+    Eigen::Vector3f pos_ = Eigen::Vector3f::Zero();
+  };
+  using TransformVector =
+      std::vector<Transform, Eigen::aligned_allocator<Transform>>;
+
+  void capture(const Simulation &sim, double time);
+  // Blends two snapshots of the same scene at parameter t in [0, 1]; if the
+  // scenes differ (e.g. a robot was added in between) the result is b
+  static void interpolate(const SimulationSnapshot &a,
+                          const SimulationSnapshot &b, double t,
+                          SimulationSnapshot &result);
+
+  double time_ = 0.0;
+  std::vector<std::shared_ptr<const Robot>> robots_;
+  std::vector<TransformVector> link_transforms_;
+  std::vector<std::shared_ptr<const Prop>> props_;
+  TransformVector prop_transforms_;
+};
+
+// Caches procedurally generated meshes keyed by their geometry parameters,
+// so requesting the same configuration again reuses the existing GL buffers
+// instead of rebuilding and re-uploading the vertex data
+class MeshCache {
+public:
+  enum class PrimitiveType { BOX, TUBE, CAPSULE_END, CYLINDER_END };
+  std::shared_ptr<Mesh> get(PrimitiveType type, int n_segments = 0,
+                            int n_rings = 0);
+
+private:
+  std::map<std::tuple<int, int, int>, std::shared_ptr<Mesh>> meshes_;
+};
+
 class GLRenderer {
 public:
   GLRenderer(const std::string &data_dir);
   void render(const Simulation &sim, const CameraParameters &camera_params,
               const RenderParameters &render_params, int width, int height,
               const Framebuffer *target_framebuffer = nullptr);
+  void render(const SimulationSnapshot &snapshot,
+              const CameraParameters &camera_params,
+              const RenderParameters &render_params, int width, int height,
+              const Framebuffer *target_framebuffer = nullptr);
 
 private:
-  void drawOpaque(const Simulation &sim, const Program &program,
-                  ProgramState &program_state) const;
-  void drawLabels(const Simulation &sim, const Program &program,
-                  ProgramState &program_state) const;
+  // Builds the per-frame instance lists for every robot link and streams
+  // them into the instance buffers; called once per frame
+  void collectLinkInstances(const SimulationSnapshot &snapshot);
+  static void addMeshInstance(std::vector<MeshInstance> &instances,
+                              const Eigen::Matrix4f &model_matrix,
+                              const Eigen::Matrix4f &tex_coords_matrix,
+                              const Eigen::Vector3f &color,
+                              int proc_texture_type);
+  void addTubeBasedShapeInstances(std::vector<MeshInstance> &end_instances,
+                                  const Eigen::Matrix4f &transform,
+                                  float half_length, float radius,
+                                  const Eigen::Vector3f &color,
+                                  int proc_texture_type);
+  // Draws all collected link instances, one instanced draw per primitive
+  void drawLinkInstances(const Program &program,
+                         ProgramState &program_state) const;
+  void drawProps(const SimulationSnapshot &snapshot, const Program &program,
+                 ProgramState &program_state);
+  void drawLabels(const SimulationSnapshot &snapshot, const Program &program,
+                  ProgramState &program_state);
   void drawBox(const Eigen::Matrix4f &transform,
                const Eigen::Vector3f &half_extents, const Program &program,
                ProgramState &program_state) const;
-  void drawCapsule(const Eigen::Matrix4f &transform, float half_length,
-                   float radius, const Program &program,
-                   ProgramState &program_state) const;
-  void drawCylinder(const Eigen::Matrix4f &transform, float half_length,
-                    float radius, const Program &program,
-                    ProgramState &program_state) const;
-  void drawTubeBasedShape(const Eigen::Matrix4f &transform, float half_length,
-                          float radius, const Program &program,
-                          ProgramState &program_state,
-                          const Mesh &end_mesh) const;
   void drawText(const Eigen::Matrix4f &transform, float half_height,
                 const Program &program, ProgramState &program_state,
-                const std::string &str) const;
-  void drawHeightfield(const Eigen::Matrix4f &transform,
-                       const Eigen::Vector3f &half_extents,
-                       const Program &program, ProgramState &program_state,
-                       const Eigen::MatrixXf &heightfield) const;
+                const std::string &str);
+  // Builds a unit-height mesh of textured glyph quads for str, or returns
+  // the cached one
+  std::shared_ptr<Mesh> getTextMesh(const std::string &str);
+  void drawHeightfield(const Mesh &mesh, const Eigen::Matrix4f &transform,
+                       const Eigen::Vector3f &half_extents, int rows, int cols,
+                       const Program &program,
+                       ProgramState &program_state) const;
   static std::string loadString(const std::string &path);
 
   std::shared_ptr<Program> default_program_;
   std::shared_ptr<Program> flat_program_;
   std::shared_ptr<Program> depth_program_;
   std::shared_ptr<Program> msdf_program_;
+  std::shared_ptr<Program> default_instanced_program_;
+  std::shared_ptr<Program> flat_instanced_program_;
+  std::shared_ptr<Program> depth_instanced_program_;
+  MeshCache mesh_cache_;
   std::shared_ptr<Mesh> box_mesh_;
   std::shared_ptr<Mesh> tube_mesh_;
   std::shared_ptr<Mesh> capsule_end_mesh_;
   std::shared_ptr<Mesh> cylinder_end_mesh_;
-  std::shared_ptr<Mesh> text_mesh_;
-  std::shared_ptr<Mesh> heightfield_mesh_;
+  // Glyph quad meshes keyed by label string; cleared when it grows too large
+  std::unordered_map<std::string, std::shared_ptr<Mesh>> text_mesh_cache_;
+  // Heightfield meshes keyed by prop; holding the key shared_ptr keeps the
+  // cached geometry valid for as long as the prop could reappear
+  std::map<std::shared_ptr<const Prop>, std::shared_ptr<Mesh>>
+      heightfield_mesh_cache_;
+  std::shared_ptr<InstanceBuffer> box_instance_buffer_;
+  std::shared_ptr<InstanceBuffer> tube_instance_buffer_;
+  std::shared_ptr<InstanceBuffer> capsule_end_instance_buffer_;
+  std::shared_ptr<InstanceBuffer> cylinder_end_instance_buffer_;
+  std::vector<MeshInstance> box_instances_;
+  std::vector<MeshInstance> tube_instances_;
+  std::vector<MeshInstance> capsule_end_instances_;
+  std::vector<MeshInstance> cylinder_end_instances_;
+  // Scratch snapshot for the Simulation-based render overload
+  SimulationSnapshot scene_snapshot_;
   std::shared_ptr<DirectionalLight> dir_light_;
   std::shared_ptr<BitmapFont> font_;
 };
@@ -367,6 +477,8 @@ std::shared_ptr<Mesh> makeCapsuleEndMesh(int n_segments, int n_rings);
 
 std::shared_ptr<Mesh> makeCylinderEndMesh(int n_segments);
 
+std::shared_ptr<Mesh> makeHeightfieldMesh(const Eigen::MatrixXf &heightfield);
+
 std::shared_ptr<Texture2D> loadTexture(const std::string &path);
 
 } // namespace robot_design
@@ -3,6 +3,7 @@
 #include <Eigen/Dense>
 #include <Eigen/StdVector>
 #include <functional>
+#include <memory>
 #include <robot_design/types.h>
 #include <type_traits>
 #include <vector>
@@ -75,6 +76,34 @@ struct Robot {
   std::vector<Link, Eigen::aligned_allocator<Link>> links_;
 };
 
+// Flat structure-of-arrays form of a Robot, compiled once with
+// compileRobotData and shared across every simulation instance of a run;
+// consumers stream sequentially through these arrays instead of re-walking
+// the array-of-structs Link vector per instance
+struct RobotData {
+  // The source robot, kept alive for code which needs the original links
+  std::shared_ptr<const Robot> robot_;
+  // Per-link parameters
+  std::vector<Index> parents_;
+  std::vector<JointType> joint_types_;
+  std::vector<LinkShape> shapes_;
+  VectorX lengths_;
+  VectorX radii_;
+  VectorX densities_;
+  VectorX frictions_;
+  VectorX link_masses_;
+  VectorX joint_positions_;
+  std::vector<Quaternion, Eigen::aligned_allocator<Quaternion>> joint_rots_;
+  Eigen::Matrix<Scalar, 3, Eigen::Dynamic> joint_axes_;
+  // Per-dof parameters, expanded so gains can be copied wholesale
+  int dof_count_;
+  VectorX dof_kp_;
+  VectorX dof_kd_;
+  VectorX dof_torques_;
+};
+
+RobotData compileRobotData(std::shared_ptr<const Robot> robot);
+
 } // namespace robot_design
 
 namespace std {
@@ -6,15 +6,27 @@
 #include <BulletDynamics/Featherstone/btMultiBodyLinkCollider.h>
 #include <Serialize/BulletFileLoader/btBulletFile.h>
 #include <btBulletDynamicsCommon.h>
+#include <functional>
+#include <map>
 #include <memory>
 #include <robot_design/prop.h>
 #include <robot_design/robot.h>
 #include <robot_design/types.h>
+#include <tuple>
 
 namespace robot_design {
 
 using Eigen::Ref;
 
+// A single cached contact point involving one of a robot's links
+struct ContactPoint {
+  Vector3 point_;
+  Vector3 normal_;
+  Scalar distance_;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+};
+
 class Simulation {
 public:
   virtual ~Simulation() {}
@@ -46,6 +58,15 @@ public:
                                         Ref<VectorX> target_vel) const = 0;
   virtual void getJointMotorTorques(Index robot_idx,
                                     Ref<VectorX> motor_torques) const = 0;
+  // Size of the fixed-size prefix of a full state vector; see getFullState
+  static constexpr int FULL_STATE_BASE_SIZE = 22;
+  // Packs the robot's full dynamic state into one caller-owned buffer of
+  // size FULL_STATE_BASE_SIZE + 3 * getRobotDofCount(robot_idx):
+  //   [0, 16)   base link transform (column-major 4x4)
+  //   [16, 22)  base link velocity (angular, then linear)
+  // followed by the joint positions, joint velocities, and joint motor
+  // torques, each of length getRobotDofCount(robot_idx)
+  virtual void getFullState(Index robot_idx, Ref<VectorX> state) const = 0;
   virtual void setJointTargets(Index robot_idx,
                                const Ref<const VectorX> &target) = 0;
   virtual void
@@ -62,6 +83,8 @@ public:
   virtual void getRobotWorldAABB(Index robot_idx, Ref<Vector3> lower,
                                  Ref<Vector3> upper) const = 0;
   virtual bool robotHasCollision(Index robot_idx) const = 0;
+  virtual const std::vector<ContactPoint> &
+  getRobotContacts(Index robot_idx) const = 0;
   virtual Scalar getTimeStep() const = 0;
   virtual Vector3 getGravity() const = 0;
   virtual void setGravity(const Ref<const Vector3> &gravity) = 0;
@@ -81,9 +104,33 @@ struct BulletRobotWrapper {
   VectorX joint_kd_;
   VectorX joint_target_pos_;
   VectorX joint_target_vel_;
+  // Targets at the end of the previous step(), used to interpolate PD
+  // targets across substeps
+  VectorX prev_joint_target_pos_;
+  VectorX prev_joint_target_vel_;
   VectorX joint_motor_torques_;
 };
 
+// One lazily instantiated tile of a TiledHeightfieldProp; a separate static
+// collision object whose AABB lets the broadphase cull distant terrain
+struct BulletTerrainTile {
+  // Owned contiguous copy of the tile's sample block; copying it out of the
+  // prop faults in the corresponding pages of a memory-mapped heightfield
+  MatrixX heights_;
+  std::shared_ptr<btCollisionShape> shape_;
+  std::shared_ptr<btRigidBody> body_;
+  // Steps since a robot was last near this tile; evicted once stale
+  int stale_steps_ = 0;
+};
+
+struct BulletTiledTerrain {
+  std::shared_ptr<const TiledHeightfieldProp> prop_;
+  int tile_row_count_ = 0;
+  int tile_col_count_ = 0;
+  // Active tiles keyed by tile_row * tile_col_count_ + tile_col
+  std::map<int, BulletTerrainTile> tiles_;
+};
+
 struct BulletPropWrapper {
   BulletPropWrapper(std::shared_ptr<const Prop> prop)
       : prop_(prop), rigid_body_(), col_shape_(), col_object_() {}
@@ -91,6 +138,9 @@ struct BulletPropWrapper {
   std::shared_ptr<btRigidBody> rigid_body_;
   std::shared_ptr<btCollisionShape> col_shape_;
   std::shared_ptr<btCollisionObject> col_object_;
+  // Only set for TiledHeightfieldProp; rigid_body_ is then an empty-shaped
+  // anchor carrying the prop transform and the tiles collide instead
+  std::shared_ptr<BulletTiledTerrain> tiled_terrain_;
 };
 
 struct BulletSavedState {
@@ -103,14 +153,45 @@ struct BulletSavedState {
   std::shared_ptr<bParse::btBulletFile> bullet_file_;
 };
 
+// Compact snapshot containing only pose and velocity state, stored in flat
+// preallocated buffers (much cheaper than serializing the entire world)
+struct BulletCompactState {
+  // One block per robot: base position (3), base rotation (4), base angular
+  // velocity (3), base linear velocity (3), joint positions, joint velocities
+  std::vector<VectorX> robot_states_;
+  // One block per prop: position (3), rotation (4), angular velocity (3),
+  // linear velocity (3)
+  std::vector<VectorX> prop_states_;
+  bool valid_ = false;
+};
+
+// Construction-time tuning knobs for BulletSimulation's constraint solver
+// and stepping scheme
+struct BulletSimulationProfile {
+  // Constraint solver iterations per (sub)step; Bullet's default is 10
+  int solver_iterations_ = 10;
+  // Substeps per step(). With more than one substep, the PD motor targets
+  // are interpolated from the previous step's targets across the substeps,
+  // so high-kp designs get the stability of a smaller solver timestep
+  // without changing the control rate or the meaning of getTimeStep()
+  int substep_count_ = 1;
+};
+
 class BulletSimulation : public Simulation {
 public:
-  BulletSimulation(Scalar time_step = 1.0 / 240);
+  BulletSimulation(Scalar time_step = 1.0 / 240,
+                   const BulletSimulationProfile &profile =
+                       BulletSimulationProfile());
   virtual ~BulletSimulation();
   BulletSimulation(const BulletSimulation &other) = delete;
   BulletSimulation &operator=(const BulletSimulation &other) = delete;
   virtual Index addRobot(std::shared_ptr<const Robot> robot, const Vector3 &pos,
                          const Quaternion &rot) override;
+  // Fast path which consumes a precompiled flat robot description; compile
+  // the RobotData once and share it across all sim instances of a run. The
+  // Robot overload above compiles one on the fly
+  Index addRobot(std::shared_ptr<const RobotData> robot_data,
+                 const Vector3 &pos, const Quaternion &rot);
   virtual Index addProp(std::shared_ptr<const Prop> prop, const Vector3 &pos,
                         const Quaternion &rot) override;
   virtual void removeRobot(Index robot_idx) override;
@@ -139,6 +220,14 @@ public:
                                         Ref<VectorX> target_vel) const override;
   virtual void getJointMotorTorques(Index robot_idx,
                                     Ref<VectorX> motor_torques) const override;
+  virtual void getFullState(Index robot_idx,
+                            Ref<VectorX> state) const override;
+  // Refreshes and returns a persistent per-robot packed state buffer (see
+  // getFullState for the layout). The Python bindings expose the result as
+  // a zero-copy view: each call updates the buffer in place, and the buffer
+  // is only reallocated (invalidating outstanding views) when the robot's
+  // dof count changes, i.e. when robots are added or removed
+  VectorX &refreshFullStateBuffer(Index robot_idx);
   virtual void setJointTargets(Index robot_idx,
                                const Ref<const VectorX> &target) override;
   virtual void
@@ -155,12 +244,39 @@ public:
   virtual void getRobotWorldAABB(Index robot_idx, Ref<Vector3> lower,
                                  Ref<Vector3> upper) const override;
   virtual bool robotHasCollision(Index robot_idx) const override;
+  virtual const std::vector<ContactPoint> &
+  getRobotContacts(Index robot_idx) const override;
   virtual Scalar getTimeStep() const override;
   virtual Vector3 getGravity() const override;
   virtual void setGravity(const Ref<const Vector3> &gravity) override;
   virtual void saveState() override;
   virtual void restoreState() override;
+  // Slot-addressed snapshot ring for tree-structured rollouts: save each
+  // branching depth into its own slot and roll back to any of them without
+  // re-simulating the shared prefix. Slots always use the compact state
+  // path, so saving costs one copy of the pose/velocity state. Size the
+  // ring with setStateRingSize before use
+  void saveState(int slot);
+  void restoreState(int slot);
+  void setStateRingSize(int slot_count);
+  int getStateRingSize() const;
+  // Copies this simulation's pose/velocity state into other, which must
+  // contain the same robots and props; lets a branch be handed off to an
+  // idle worker's simulation instance
+  void cloneStateInto(BulletSimulation &other) const;
+  // Flat (wire-friendly) form of the compact snapshot: all robot state
+  // blocks followed by all prop state blocks, concatenated in index order.
+  // The size is fixed while the set of robots and props is unchanged, and
+  // the layout matches between identically constructed simulations, so a
+  // packed state can be restored in another process
+  int getPackedStateSize() const;
+  void getPackedState(Ref<VectorX> packed_state) const;
+  void setPackedState(const Ref<const VectorX> &packed_state);
   virtual void step() override;
+  // Full serialization preserves contact manifolds but is much slower, only
+  // enable it if the compact snapshot path loses state you care about
+  void setFullStateSerialization(bool full_state_serialization);
+  bool getFullStateSerialization() const;
 
 private:
   struct OverlapFilterCallback : public btOverlapFilterCallback {
@@ -169,10 +285,32 @@ private:
                             btBroadphaseProxy *proxy1) const override;
   };
 
+  // Collision shapes are recycled through a pool keyed by their dimensions,
+  // and link colliders through a free list, so removing a robot and adding
+  // another one with the same link dimensions does not hit the heap
+  using ShapePoolKey = std::tuple<LinkShape, Scalar, Scalar>;
+
   void unregisterRobotWrapper(BulletRobotWrapper &robot_wrapper);
   void unregisterPropWrapper(BulletPropWrapper &prop_wrapper);
+  void saveCompactState(BulletCompactState &state) const;
+  void restoreCompactState(const BulletCompactState &state);
+  std::shared_ptr<btCollisionShape> acquireLinkShape(LinkShape shape,
+                                                     Scalar length,
+                                                     Scalar radius);
+  std::shared_ptr<btMultiBodyLinkCollider>
+  acquireLinkCollider(btMultiBody *multi_body, int link_idx);
+  // Scans the dispatcher's manifolds once and buckets contacts per robot;
+  // robotHasCollision and getRobotContacts then read the cached index
+  void rebuildContactIndex() const;
+  // Instantiates terrain tiles near robot AABBs and evicts tiles that have
+  // been far from every robot for a while; called once per step()
+  void updateTerrainTiles();
+  void instantiateTerrainTile(BulletPropWrapper &prop_wrapper, int tile_row,
+                              int tile_col);
 
   Scalar time_step_;
+  BulletSimulationProfile profile_;
+  bool full_state_serialization_ = false;
   OverlapFilterCallback overlap_filter_callback_;
   std::shared_ptr<btDefaultCollisionConfiguration> collision_config_;
   std::shared_ptr<btHashedOverlappingPairCache> pair_cache_;
@@ -183,6 +321,51 @@ private:
   std::vector<BulletRobotWrapper> robot_wrappers_;
   std::vector<BulletPropWrapper> prop_wrappers_;
   BulletSavedState saved_state_;
+  BulletCompactState compact_state_;
+  std::vector<BulletCompactState> state_ring_;
+  // Scratch buffer filled by another simulation's cloneStateInto and by the
+  // packed state accessors; mutable so getPackedState stays const
+  mutable BulletCompactState clone_scratch_state_;
+  std::map<ShapePoolKey, std::vector<std::shared_ptr<btCollisionShape>>>
+      shape_pool_;
+  std::vector<std::shared_ptr<btMultiBodyLinkCollider>> collider_pool_;
+  mutable bool contact_index_dirty_ = true;
+  mutable std::vector<std::vector<ContactPoint>> robot_contacts_;
+  mutable std::vector<bool> robot_has_collision_;
+  // Persistent packed state buffers backing zero-copy views
+  std::vector<VectorX> full_state_buffers_;
+};
+
+using MakeBulletSimFunction = std::function<std::shared_ptr<BulletSimulation>()>;
+
+// Owns a batch of identically constructed worlds, each containing one robot,
+// and stores joint targets, gains, and readback state in structure-of-arrays
+// matrices (dof_count x world_count) so the per-step PD target math becomes a
+// single Eigen pass over all worlds
+class SimulationBatch {
+public:
+  SimulationBatch(int world_count, const MakeBulletSimFunction &make_sim_fn);
+  Index getWorldCount() const;
+  int getDofCount() const;
+  BulletSimulation &getWorld(Index world_idx);
+  const BulletSimulation &getWorld(Index world_idx) const;
+  // Each column contains the joint targets for one world
+  void setJointTargetsAll(const Ref<const MatrixX> &targets);
+  // Each column contains the joint positions/velocities for one world
+  void getJointStateAll(Ref<MatrixX> pos, Ref<MatrixX> vel) const;
+  void saveStateAll();
+  void restoreStateAll();
+  void stepAll();
+
+private:
+  int dof_count_;
+  std::vector<std::shared_ptr<BulletSimulation>> worlds_;
+  // Per-dof control modes and velocity scaling, identical across worlds
+  std::vector<JointControlMode> joint_control_modes_;
+  MatrixX joint_target_pos_;
+  MatrixX joint_target_vel_;
+  MatrixX joint_pos_;
+  MatrixX joint_vel_;
 };
 
 } // namespace robot_design
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <robot_design/robot.h>
+#include <robot_design/sim.h>
+#include <robot_design/types.h>
+#include <string>
+
+namespace robot_design {
+
+// On-disk header of a trajectory log file; frames follow immediately after,
+// each one a packed full state (see Simulation::getFullState for the
+// layout) with a fixed stride of frame_size_ Scalars
+struct TrajectoryLogHeader {
+  char magic_[4];
+  std::uint32_t version_;
+  // sizeof(Scalar) when the file was written
+  std::uint32_t scalar_size_;
+  // Scalars per frame
+  std::uint32_t frame_size_;
+  std::uint64_t frame_count_;
+  // Digest of the recorded robot's structure, for matching logs to designs
+  std::uint64_t robot_digest_;
+  double time_step_;
+};
+
+std::uint64_t computeRobotDigest(const Robot &robot);
+
+// Appends one packed full-state frame per recordStep call into a
+// memory-mapped binary file, growing the mapping in chunks; recording costs
+// a single packed state write directly into the mapped region. Leave one of
+// these attached to every rollout sim and analyze the files afterwards
+// instead of re-simulating
+class TrajectoryLogWriter {
+public:
+  TrajectoryLogWriter(const std::string &path, const Simulation &sim,
+                      Index robot_idx, int chunk_frame_count = 4096);
+  virtual ~TrajectoryLogWriter();
+  TrajectoryLogWriter(const TrajectoryLogWriter &other) = delete;
+  TrajectoryLogWriter &operator=(const TrajectoryLogWriter &other) = delete;
+  void recordStep(const Simulation &sim);
+  std::size_t getFrameCount() const { return frame_count_; }
+  // Finalizes the header, truncates the file to its exact size, and unmaps
+  // it; called automatically on destruction
+  void close();
+
+private:
+  void remapForCapacity(std::size_t frame_capacity);
+
+  std::string path_;
+  Index robot_idx_;
+  int chunk_frame_count_;
+  std::size_t frame_size_;
+  std::size_t frame_count_ = 0;
+  std::size_t frame_capacity_ = 0;
+  std::uint64_t robot_digest_;
+  Scalar time_step_;
+  int fd_ = -1;
+  char *data_ = nullptr;
+  std::size_t mapped_size_ = 0;
+};
+
+// Memory-maps a trajectory log read-only and exposes the frames as a
+// zero-copy Eigen view (one frame per column); the Python bindings return
+// the view as a numpy array backed by the mapping
+class TrajectoryLogReader {
+public:
+  explicit TrajectoryLogReader(const std::string &path);
+  virtual ~TrajectoryLogReader();
+  TrajectoryLogReader(const TrajectoryLogReader &other) = delete;
+  TrajectoryLogReader &operator=(const TrajectoryLogReader &other) = delete;
+  int getFrameSize() const { return header_->frame_size_; }
+  std::size_t getFrameCount() const { return header_->frame_count_; }
+  std::uint64_t getRobotDigest() const { return header_->robot_digest_; }
+  Scalar getTimeStep() const { return header_->time_step_; }
+  Eigen::Map<const MatrixX> getFrames() const;
+
+private:
+  const TrajectoryLogHeader *header_ = nullptr;
+  int fd_ = -1;
+  char *data_ = nullptr;
+  std::size_t mapped_size_ = 0;
+};
+
+} // namespace robot_design
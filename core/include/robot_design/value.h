@@ -21,6 +21,51 @@ public:
   virtual void train(const MatrixX &obs, const Ref<const VectorX> &value) = 0;
 };
 
+// Fully connected ReLU network evaluated natively with Eigen, so inference
+// runs inside the optimizer process with no Python involvement. Hidden
+// layer weights are stored as aligned row-major blocks, and estimateValue
+// is a batched matrix product over the whole observation matrix. train()
+// runs minibatch Adam on a squared error loss; alternatively, train in
+// PyTorch and import the weights with setLayerParams
+class FusedMLPValueEstimator : public ValueEstimator {
+public:
+  // Row-major weights multiply the column-major activation batch directly
+  using LayerMatrix =
+      Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  FusedMLPValueEstimator(int obs_size, const std::vector<int> &hidden_sizes,
+                         Scalar learning_rate = 1e-3, int batch_size = 64,
+                         int epoch_count = 3);
+  virtual ~FusedMLPValueEstimator() {}
+  virtual int getObservationSize() const override { return obs_size_; }
+  virtual void getObservation(const Simulation &sim,
+                              Ref<VectorX> obs) const override;
+  virtual void estimateValue(const MatrixX &obs,
+                             Ref<VectorX> value_est) const override;
+  virtual void train(const MatrixX &obs,
+                     const Ref<const VectorX> &value) override;
+  int getLayerCount() const { return static_cast<int>(weights_.size()); }
+  // Weight import/export, e.g. from a network trained in PyTorch; weight
+  // has shape (output size, input size) as in torch.nn.Linear
+  void setLayerParams(int layer_idx, const Ref<const MatrixX> &weight,
+                      const Ref<const VectorX> &bias);
+  MatrixX getLayerWeight(int layer_idx) const;
+  VectorX getLayerBias(int layer_idx) const;
+
+private:
+  int obs_size_;
+  Scalar learning_rate_;
+  int batch_size_;
+  int epoch_count_;
+  std::vector<LayerMatrix> weights_;
+  std::vector<VectorX> biases_;
+  // Adam first and second moment estimates, one pair per parameter block
+  std::vector<LayerMatrix> weight_moment1_, weight_moment2_;
+  std::vector<VectorX> bias_moment1_, bias_moment2_;
+  int adam_step_count_ = 0;
+  unsigned int shuffle_seed_ = 0;
+};
+
 class NullValueEstimator : public ValueEstimator {
 public:
   NullValueEstimator() {}
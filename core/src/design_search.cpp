@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <cmath>
+#include <robot_design/design_search.h>
+#include <robot_design/episode.h>
+#include <stdexcept>
+
+namespace robot_design {
+
+// AMAF and Monte Carlo values are weighted equally when the visit count is
+// AMAF_THRESHOLD, as in mcts.py
+constexpr Scalar AMAF_THRESHOLD = 10.0;
+
+namespace {
+
+// A graph is terminal when every node has a concrete shape and every edge a
+// concrete joint type; mirrors has_nonterminals in design_search.py
+bool hasNonterminals(const Graph &graph) {
+  for (const Node &node : graph.nodes_) {
+    if (node.attrs_.shape_ == LinkShape::NONE) {
+      return true;
+    }
+  }
+  for (const Edge &edge : graph.edges_) {
+    if (edge.attrs_.joint_type_ == JointType::NONE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Applies the rule at its first applicable match, the same successor the
+// Python env's get_next_state produces; returns false if no match applies
+bool applyFirstMatch(const Rule &rule, const Graph &graph, Graph &result) {
+  std::vector<GraphMapping> matches = findMatches(rule.lhs_, graph);
+  for (const GraphMapping &match : matches) {
+    if (checkRuleApplicability(rule, graph, match)) {
+      applyRuleInto(rule, graph, match, result);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+DesignSearch::DesignSearch(
+    const Graph &initial_graph, const std::vector<Rule> &rules,
+    int max_rule_seq_len, int max_tries, int thread_count, unsigned int seed,
+    const MakeDesignEvaluatorFunction &make_evaluator_fn)
+    : rules_(rules), max_rule_seq_len_(max_rule_seq_len),
+      max_tries_(max_tries), thread_count_(thread_count),
+      make_evaluator_fn_(make_evaluator_fn),
+      eval_seed_counter_(seed) {
+  initial_state_.graph_ = initial_graph;
+  initial_state_.key_ = hashGraph(initial_graph);
+  nodes_.emplace(initial_state_.key_,
+                 std::make_unique<DesignSearchNode>(initial_graph));
+}
+
+void DesignSearch::setResultCallback(const DesignResultCallback &callback) {
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  result_callback_ = callback;
+}
+
+int DesignSearch::getNodeCount() const {
+  std::shared_lock<std::shared_mutex> lock(nodes_mutex_);
+  return static_cast<int>(nodes_.size());
+}
+
+int DesignSearch::getEvaluationCount() const {
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  return eval_count_;
+}
+
+Scalar DesignSearch::getBestResult() const {
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  return best_result_;
+}
+
+std::vector<int> DesignSearch::getBestRuleSequence() const {
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  return best_rule_seq_;
+}
+
+void DesignSearch::run(int iteration_count) {
+  iterations_remaining_.store(iteration_count, std::memory_order_relaxed);
+  int worker_count = std::min(thread_count_, iteration_count);
+  std::vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (int i = 0; i < worker_count; ++i) {
+    workers.emplace_back([this, i]() {
+      // Each worker owns its evaluator and random stream
+      DesignEvaluator evaluator = make_evaluator_fn_();
+      std::mt19937 rng(eval_seed_counter_.fetch_add(
+          1, std::memory_order_relaxed) ^ (0x9e3779b9u * (i + 1)));
+      while (iterations_remaining_.fetch_sub(1, std::memory_order_relaxed) >
+             0) {
+        runIteration(rng, evaluator);
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+Scalar DesignSearch::uctScore(const DesignSearchNode &node,
+                              const DesignActionStats &stats) const {
+  int node_visits = node.visit_count_ + node.pending_count_;
+  int action_visits = stats.visit_count_ + stats.pending_count_;
+  Scalar amaf_weight =
+      std::sqrt(AMAF_THRESHOLD / (3 * node_visits + AMAF_THRESHOLD));
+  if (stats.visit_count_ > 0) {
+    return (1.0 - amaf_weight) * stats.result_max_ +
+           amaf_weight * stats.amaf_result_max_ +
+           std::sqrt(2.0 * std::log(std::max(node_visits, 1)) / action_visits);
+  } else {
+    // Unvisited actions are preferred over all visited ones; in-flight
+    // selections (virtual losses) push concurrent workers onto different
+    // unvisited actions
+    return std::numeric_limits<Scalar>::max() - stats.pending_count_;
+  }
+}
+
+DesignSearchNode *DesignSearch::findNode(std::size_t key) {
+  std::shared_lock<std::shared_mutex> lock(nodes_mutex_);
+  auto it = nodes_.find(key);
+  return (it != nodes_.end()) ? it->second.get() : nullptr;
+}
+
+DesignSearchNode &DesignSearch::findOrCreateNode(std::size_t key,
+                                                 const Graph &graph) {
+  {
+    std::shared_lock<std::shared_mutex> lock(nodes_mutex_);
+    auto it = nodes_.find(key);
+    if (it != nodes_.end()) {
+      return *it->second;
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(nodes_mutex_);
+  auto result = nodes_.emplace(key, std::make_unique<DesignSearchNode>(graph));
+  return *result.first->second;
+}
+
+int DesignSearch::selectAction(const SearchState &state, std::mt19937 &rng,
+                               Graph &next_graph,
+                               PendingMarks &pending_marks) {
+  if (static_cast<int>(state.rule_seq_.size()) >= max_rule_seq_len_) {
+    return -1;
+  }
+
+  // Collect rules with at least one applicable match whose successor is not
+  // blocked; successors are kept so the chosen one needs no second rewrite
+  std::vector<int> available_rules;
+  std::vector<Graph> successors;
+  Graph successor;
+  for (int rule_idx = 0; rule_idx < static_cast<int>(rules_.size());
+       ++rule_idx) {
+    if (!applyFirstMatch(rules_[rule_idx], state.graph_, successor)) {
+      continue;
+    }
+    DesignSearchNode *next_node = findNode(hashGraph(successor));
+    if (next_node) {
+      std::lock_guard<std::mutex> lock(next_node->mutex_);
+      if (next_node->blocked_) {
+        continue;
+      }
+    }
+    available_rules.push_back(rule_idx);
+    successors.push_back(successor);
+  }
+  if (available_rules.empty()) {
+    return -1;
+  }
+
+  DesignSearchNode *node = findNode(state.key_);
+  std::size_t chosen;
+  if (node) {
+    // Follow the tree policy
+    std::lock_guard<std::mutex> lock(node->mutex_);
+    chosen = 0;
+    Scalar best_score = -std::numeric_limits<Scalar>::infinity();
+    for (std::size_t i = 0; i < available_rules.size(); ++i) {
+      Scalar score = uctScore(*node, node->action_stats_[available_rules[i]]);
+      if (score > best_score) {
+        best_score = score;
+        chosen = i;
+      }
+    }
+    // Virtual loss, released at the end of the iteration attempt
+    ++node->pending_count_;
+    ++node->action_stats_[available_rules[chosen]].pending_count_;
+    pending_marks.emplace_back(node, available_rules[chosen]);
+  } else {
+    // State not visited yet, follow the default (uniform random) policy
+    chosen = std::uniform_int_distribution<std::size_t>(
+        0, available_rules.size() - 1)(rng);
+  }
+  next_graph = std::move(successors[chosen]);
+  return available_rules[chosen];
+}
+
+void DesignSearch::runIteration(std::mt19937 &rng,
+                                const DesignEvaluator &evaluator) {
+  Scalar result = std::numeric_limits<Scalar>::quiet_NaN();
+  std::vector<SearchState> states;
+  std::vector<int> actions;
+  // Virtual losses applied along the way, released after every attempt
+  PendingMarks pending_marks;
+
+  while (std::isnan(result)) {
+    // Selection phase: descend while the state is in the tree
+    states.clear();
+    actions.clear();
+    pending_marks.clear();
+    states.push_back(initial_state_);
+    Graph next_graph;
+    int rule_idx = selectAction(states.back(), rng, next_graph,
+                                pending_marks);
+    while (rule_idx >= 0 && findNode(states.back().key_)) {
+      SearchState next_state;
+      next_state.graph_ = std::move(next_graph);
+      next_state.key_ = hashGraph(next_state.graph_);
+      next_state.rule_seq_ = states.back().rule_seq_;
+      next_state.rule_seq_.push_back(rule_idx);
+      states.push_back(std::move(next_state));
+      actions.push_back(rule_idx);
+      rule_idx = selectAction(states.back(), rng, next_graph, pending_marks);
+    }
+
+    // Expansion phase
+    DesignSearchNode &last_node =
+        findOrCreateNode(states.back().key_, states.back().graph_);
+
+    // Simulation phase: finish the playout and evaluate the terminal design
+    // on this worker's private evaluator
+    for (int try_count = 0; try_count < max_tries_; ++try_count) {
+      std::vector<SearchState> sim_states = states;
+      std::vector<int> sim_actions = actions;
+      int sim_rule_idx =
+          selectAction(sim_states.back(), rng, next_graph, pending_marks);
+      while (sim_rule_idx >= 0) {
+        SearchState next_state;
+        next_state.graph_ = std::move(next_graph);
+        next_state.key_ = hashGraph(next_state.graph_);
+        next_state.rule_seq_ = sim_states.back().rule_seq_;
+        next_state.rule_seq_.push_back(sim_rule_idx);
+        sim_states.push_back(std::move(next_state));
+        sim_actions.push_back(sim_rule_idx);
+        sim_rule_idx =
+            selectAction(sim_states.back(), rng, next_graph, pending_marks);
+      }
+      if (!hasNonterminals(sim_states.back().graph_)) {
+        unsigned int eval_seed = static_cast<unsigned int>(
+            eval_seed_counter_.fetch_add(1, std::memory_order_relaxed));
+        result = evaluator(sim_states.back().graph_, eval_seed);
+      }
+      if (!std::isnan(result)) {
+        // Result is valid
+        states = std::move(sim_states);
+        actions = std::move(sim_actions);
+        break;
+      }
+    }
+
+    if (std::isnan(result)) {
+      // No valid playout after max_tries tries; block the node so the next
+      // attempt selects a different subtree
+      std::lock_guard<std::mutex> lock(last_node.mutex_);
+      last_node.blocked_ = true;
+    }
+    // Release the virtual losses regardless of the outcome
+    for (auto &[node, pending_rule_idx] : pending_marks) {
+      std::lock_guard<std::mutex> lock(node->mutex_);
+      --node->pending_count_;
+      --node->action_stats_[pending_rule_idx].pending_count_;
+    }
+  }
+
+  // Backpropagation phase
+  for (std::size_t i = 0; i + 1 < states.size(); ++i) {
+    DesignSearchNode *node = findNode(states[i].key_);
+    if (!node) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(node->mutex_);
+    ++node->visit_count_;
+    node->result_sum_ += result;
+    node->result_max_ = std::max(node->result_max_, result);
+    DesignActionStats &first = node->action_stats_[actions[i]];
+    ++first.visit_count_;
+    first.result_sum_ += result;
+    first.result_max_ = std::max(first.result_max_, result);
+    // Update AMAF values, once for each unique action taken afterwards
+    std::vector<int> unique_actions(actions.begin() + i, actions.end());
+    std::sort(unique_actions.begin(), unique_actions.end());
+    unique_actions.erase(
+        std::unique(unique_actions.begin(), unique_actions.end()),
+        unique_actions.end());
+    for (int action : unique_actions) {
+      DesignActionStats &stats = node->action_stats_[action];
+      ++stats.amaf_visit_count_;
+      stats.amaf_result_sum_ += result;
+      stats.amaf_result_max_ = std::max(stats.amaf_result_max_, result);
+    }
+  }
+
+  // Record the result under the result lock, then notify the callback with
+  // no locks held; a callback that reacquires the Python GIL must not hold
+  // result_mutex_, or a Python thread polling the getters while holding the
+  // GIL would deadlock against it
+  {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    ++eval_count_;
+    if (result > best_result_) {
+      best_result_ = result;
+      best_rule_seq_ = states.back().rule_seq_;
+    }
+  }
+  DesignResultCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    callback = result_callback_;
+  }
+  if (callback) {
+    callback(states.back().graph_, states.back().rule_seq_, result);
+  }
+}
+
+MPPIDesignEvaluator::MPPIDesignEvaluator(
+    Scalar kappa, Scalar discount_factor, int interval, int horizon,
+    int episode_len, int init_sample_count, int sample_count, int thread_count,
+    const MakeRobotSimFunction &make_robot_sim_fn,
+    const ObjectiveFunction &objective_fn,
+    const std::shared_ptr<const InputSampler> &input_sampler)
+    : kappa_(kappa), discount_factor_(discount_factor), interval_(interval),
+      horizon_(horizon), episode_len_(episode_len),
+      init_sample_count_(init_sample_count), sample_count_(sample_count),
+      thread_count_(thread_count), make_robot_sim_fn_(make_robot_sim_fn),
+      objective_fn_(objective_fn), input_sampler_(input_sampler) {}
+
+Scalar MPPIDesignEvaluator::operator()(const Graph &graph,
+                                       unsigned int seed) const {
+  // Probe once to reject invalid designs and read off the dof count
+  std::shared_ptr<Simulation> probe_sim = make_robot_sim_fn_(graph);
+  if (!probe_sim || probe_sim->getRobotCount() == 0) {
+    return std::numeric_limits<Scalar>::quiet_NaN();
+  }
+  int dof_count = probe_sim->getRobotDofCount(0);
+
+  auto value_estimator = std::make_shared<NullValueEstimator>();
+  MakeSimFunction make_sim_fn = [this, &graph]() {
+    return make_robot_sim_fn_(graph);
+  };
+  EpisodeRunner runner(kappa_, discount_factor_, dof_count, interval_,
+                       horizon_, episode_len_, init_sample_count_,
+                       sample_count_, thread_count_, seed, make_sim_fn,
+                       objective_fn_, value_estimator, input_sampler_);
+  MatrixX input_sequence(dof_count, episode_len_);
+  VectorX rewards(episode_len_ * interval_);
+  MatrixX obs(0, episode_len_ + 1);
+  return runner.run(input_sequence, rewards, obs);
+}
+
+} // namespace robot_design
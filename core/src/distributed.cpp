@@ -0,0 +1,303 @@
+#include <cerrno>
+#include <cstring>
+#include <robot_design/distributed.h>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace robot_design {
+
+namespace {
+
+void sendAll(int fd, const void *data, std::size_t size) {
+  const char *ptr = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t sent = ::send(fd, ptr, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Rollout connection send failed: ") +
+                               std::strerror(errno));
+    }
+    ptr += sent;
+    size -= sent;
+  }
+}
+
+void recvAll(int fd, void *data, std::size_t size) {
+  char *ptr = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t received = ::recv(fd, ptr, size, 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Rollout connection recv failed: ") +
+                               std::strerror(errno));
+    }
+    if (received == 0) {
+      throw std::runtime_error("Rollout connection closed unexpectedly");
+    }
+    ptr += received;
+    size -= received;
+  }
+}
+
+// Returns true if a full header was read, false on a clean EOF before any
+// bytes arrived (the coordinator hung up between requests)
+bool recvHeader(int fd, RolloutRequestHeader &header) {
+  char *ptr = reinterpret_cast<char *>(&header);
+  std::size_t size = sizeof(header);
+  while (size > 0) {
+    ssize_t received = ::recv(fd, ptr, size, 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Rollout connection recv failed: ") +
+                               std::strerror(errno));
+    }
+    if (received == 0) {
+      if (size == sizeof(header)) {
+        return false;
+      }
+      throw std::runtime_error("Rollout connection closed mid-request");
+    }
+    ptr += received;
+    size -= received;
+  }
+  return true;
+}
+
+} // namespace
+
+RemoteRolloutClient::RemoteRolloutClient(const std::string &host, int port,
+                                         int sample_share)
+    : sample_share_(sample_share) {
+  if (sample_share <= 0) {
+    throw std::invalid_argument("Worker sample share must be positive");
+  }
+  struct addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *result = nullptr;
+  std::string port_str = std::to_string(port);
+  int status = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result);
+  if (status != 0) {
+    throw std::runtime_error("Could not resolve rollout worker host \"" +
+                             host + "\": " + gai_strerror(status));
+  }
+  for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+    fd_ = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd_ < 0) {
+      continue;
+    }
+    if (::connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0) {
+      break;
+    }
+    ::close(fd_);
+    fd_ = -1;
+  }
+  ::freeaddrinfo(result);
+  if (fd_ < 0) {
+    throw std::runtime_error("Could not connect to rollout worker " + host +
+                             ":" + port_str);
+  }
+  // Requests are latency-sensitive and already batched
+  int flag = 1;
+  ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+RemoteRolloutClient::~RemoteRolloutClient() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+void RemoteRolloutClient::requestRollouts(
+    unsigned int sample_seed, int sample_start, int sample_count,
+    const Ref<const VectorX> &packed_state,
+    const Ref<const MatrixX> &input_sequence,
+    const Ref<const MatrixX> &history) {
+  RolloutRequestHeader header;
+  header.magic_ = ROLLOUT_REQUEST_MAGIC;
+  header.sample_seed_ = sample_seed;
+  header.sample_start_ = sample_start;
+  header.sample_count_ = sample_count;
+  header.state_size_ = static_cast<std::int32_t>(packed_state.size());
+  header.dof_count_ = static_cast<std::int32_t>(input_sequence.rows());
+  header.horizon_ = static_cast<std::int32_t>(input_sequence.cols());
+  sendAll(fd_, &header, sizeof(header));
+  // Eigen Refs from the optimizer are dense column-major blocks
+  VectorX state_copy = packed_state;
+  MatrixX input_seq_copy = input_sequence;
+  MatrixX history_copy = history;
+  sendAll(fd_, state_copy.data(), state_copy.size() * sizeof(Scalar));
+  sendAll(fd_, input_seq_copy.data(), input_seq_copy.size() * sizeof(Scalar));
+  sendAll(fd_, history_copy.data(), history_copy.size() * sizeof(Scalar));
+}
+
+void RemoteRolloutClient::collectResults(Ref<VectorX> returns,
+                                         Ref<MatrixX> final_obs) {
+  RolloutResponseHeader header;
+  recvAll(fd_, &header, sizeof(header));
+  if (header.magic_ != ROLLOUT_RESPONSE_MAGIC) {
+    throw std::runtime_error("Invalid rollout response header");
+  }
+  if (header.sample_count_ != returns.size() ||
+      header.obs_size_ != final_obs.rows()) {
+    throw std::runtime_error("Rollout response shape mismatch");
+  }
+  VectorX returns_buf(header.sample_count_);
+  recvAll(fd_, returns_buf.data(), returns_buf.size() * sizeof(Scalar));
+  returns = returns_buf;
+  if (header.obs_size_ > 0) {
+    MatrixX obs_buf(header.obs_size_, header.sample_count_);
+    recvAll(fd_, obs_buf.data(), obs_buf.size() * sizeof(Scalar));
+    final_obs = obs_buf;
+  }
+}
+
+RolloutWorkerServer::RolloutWorkerServer(
+    int port, Scalar discount_factor, int interval, int thread_count,
+    const MakeSimFunction &make_sim_fn, const ObjectiveFunction &objective_fn,
+    const std::shared_ptr<const ValueEstimator> &value_estimator,
+    const std::shared_ptr<const InputSampler> &input_sampler)
+    : discount_factor_(discount_factor), interval_(interval),
+      make_sim_fn_(make_sim_fn), objective_fn_(objective_fn),
+      value_estimator_(value_estimator), input_sampler_(input_sampler),
+      rollout_executor_(thread_count) {
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    throw std::runtime_error(std::string("Could not create socket: ") +
+                             std::strerror(errno));
+  }
+  int flag = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(static_cast<std::uint16_t>(port));
+  if (::bind(listen_fd_, reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) < 0) {
+    throw std::runtime_error(std::string("Could not bind to port ") +
+                             std::to_string(port) + ": " +
+                             std::strerror(errno));
+  }
+  if (::listen(listen_fd_, 1) < 0) {
+    throw std::runtime_error(std::string("Could not listen: ") +
+                             std::strerror(errno));
+  }
+}
+
+RolloutWorkerServer::~RolloutWorkerServer() {
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+  }
+}
+
+void RolloutWorkerServer::serve() {
+  while (true) {
+    serveOnce();
+  }
+}
+
+void RolloutWorkerServer::serveOnce() {
+  int fd = ::accept(listen_fd_, nullptr, nullptr);
+  if (fd < 0) {
+    throw std::runtime_error(std::string("Accept failed: ") +
+                             std::strerror(errno));
+  }
+  int flag = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+  try {
+    handleConnection(fd);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+}
+
+void RolloutWorkerServer::ensureSimInstances(int count) {
+  while (static_cast<int>(sim_instances_.size()) < count) {
+    auto sim =
+        std::dynamic_pointer_cast<BulletSimulation>(make_sim_fn_());
+    if (!sim) {
+      throw std::invalid_argument(
+          "Distributed rollouts require BulletSimulation instances");
+    }
+    sim_instances_.push_back(std::move(sim));
+  }
+}
+
+void RolloutWorkerServer::handleConnection(int fd) {
+  RolloutRequestHeader header;
+  while (recvHeader(fd, header)) {
+    if (header.magic_ != ROLLOUT_REQUEST_MAGIC) {
+      throw std::runtime_error("Invalid rollout request header");
+    }
+    int sample_count = header.sample_count_;
+    int dof_count = header.dof_count_;
+    int horizon = header.horizon_;
+    VectorX packed_state(header.state_size_);
+    MatrixX input_sequence(dof_count, horizon);
+    MatrixX history(dof_count, horizon);
+    recvAll(fd, packed_state.data(), packed_state.size() * sizeof(Scalar));
+    recvAll(fd, input_sequence.data(),
+            input_sequence.size() * sizeof(Scalar));
+    recvAll(fd, history.data(), history.size() * sizeof(Scalar));
+
+    ensureSimInstances(sample_count);
+    int obs_size = value_estimator_->getObservationSize();
+    VectorX returns(sample_count);
+    MatrixX final_obs(obs_size, sample_count);
+    MatrixX input_seqs(dof_count * horizon, sample_count);
+
+    rollout_executor_.run(sample_count, [&](int i) {
+      BulletSimulation &sim = *sim_instances_[i];
+      Index robot_idx = 0; // TODO: don't assume there is only one robot
+      int sample_idx = header.sample_start_ + i;
+      // Reproduce the same input sequence the coordinator regenerates
+      // locally for weighting
+      Eigen::Map<MatrixX> input_seq(input_seqs.col(i).data(), dof_count,
+                                    horizon);
+      input_sampler_->sampleInputSequence(input_seq, header.sample_seed_,
+                                          sample_idx, input_sequence,
+                                          history);
+      sim.setPackedState(packed_state);
+      Scalar sim_return = 0.0;
+      Scalar discount_prod = 1.0;
+      for (int j = 0; j < horizon; ++j) {
+        for (int k = 0; k < interval_; ++k) {
+          sim.setJointTargets(robot_idx, input_seq.col(j));
+          sim.step();
+          sim_return += objective_fn_(sim) * discount_prod;
+        }
+        discount_prod *= discount_factor_;
+      }
+      returns(i) = sim_return;
+      if (obs_size > 0) {
+        value_estimator_->getObservation(sim, final_obs.col(i));
+      }
+    });
+
+    RolloutResponseHeader response;
+    response.magic_ = ROLLOUT_RESPONSE_MAGIC;
+    response.sample_count_ = sample_count;
+    response.obs_size_ = obs_size;
+    sendAll(fd, &response, sizeof(response));
+    sendAll(fd, returns.data(), returns.size() * sizeof(Scalar));
+    if (obs_size > 0) {
+      sendAll(fd, final_obs.data(), final_obs.size() * sizeof(Scalar));
+    }
+  }
+}
+
+} // namespace robot_design
@@ -0,0 +1,49 @@
+#include <robot_design/episode.h>
+
+namespace robot_design {
+
+EpisodeRunner::EpisodeRunner(
+    Scalar kappa, Scalar discount_factor, int dof_count, int interval,
+    int horizon, int episode_len, int init_sample_count, int sample_count,
+    int thread_count, unsigned int seed, const MakeSimFunction &make_sim_fn,
+    const ObjectiveFunction &objective_fn,
+    const std::shared_ptr<const ValueEstimator> &value_estimator,
+    const std::shared_ptr<const InputSampler> &input_sampler)
+    : interval_(interval), episode_len_(episode_len),
+      sample_count_(sample_count), objective_fn_(objective_fn),
+      value_estimator_(value_estimator), main_sim_(make_sim_fn()),
+      optimizer_(kappa, discount_factor, dof_count, interval, horizon,
+                 init_sample_count, thread_count, seed, make_sim_fn,
+                 objective_fn, value_estimator, input_sampler) {}
+
+Scalar EpisodeRunner::run(Ref<MatrixX> input_sequence, Ref<VectorX> rewards,
+                          Ref<MatrixX> obs) {
+  Index robot_idx = 0; // TODO: don't assume there is only one robot
+
+  // Warm-start with a full-size update, then drop to the per-step sample
+  // count
+  optimizer_.update();
+  optimizer_.setSampleCount(sample_count_);
+
+  for (int j = 0; j < episode_len_; ++j) {
+    optimizer_.update();
+    input_sequence.col(j) = optimizer_.input_sequence_.col(0);
+    optimizer_.advance(1);
+
+    if (obs.rows() > 0) {
+      value_estimator_->getObservation(*main_sim_, obs.col(j));
+    }
+    for (int k = 0; k < interval_; ++k) {
+      main_sim_->setJointTargets(robot_idx, input_sequence.col(j));
+      main_sim_->step();
+      rewards(j * interval_ + k) = objective_fn_(*main_sim_);
+    }
+  }
+  if (obs.rows() > 0) {
+    value_estimator_->getObservation(*main_sim_, obs.col(episode_len_));
+  }
+
+  return rewards.mean();
+}
+
+} // namespace robot_design
@@ -37,15 +37,41 @@ GLRenderer::GLRenderer(const std::string &data_dir) {
   std::string msdf_fs_source = loadString(data_dir + "shaders/msdf.frag.glsl");
   msdf_program_ = std::make_shared<Program>(msdf_vs_source, msdf_fs_source);
 
-  // Create meshes
-  box_mesh_ = makeBoxMesh();
-  tube_mesh_ = makeTubeMesh(/*n_segments=*/32);
-  capsule_end_mesh_ = makeCapsuleEndMesh(/*n_segments=*/32, /*n_rings=*/8);
-  cylinder_end_mesh_ = makeCylinderEndMesh(/*n_segments=*/32);
-  // drawText will create new vertex data for each string
-  text_mesh_ = std::make_shared<Mesh>(/*usage=*/GL_STREAM_DRAW);
-  // drawHeightfield will create new vertex data for each heightfield
-  heightfield_mesh_ = std::make_shared<Mesh>(/*usage=*/GL_STREAM_DRAW);
+  // Create instanced variants, which source the model matrix, texture
+  // transform, color, and procedural texture id from per-instance attributes
+  std::string default_instanced_vs_source =
+      loadString(data_dir + "shaders/default_instanced.vert.glsl");
+  std::string default_instanced_fs_source =
+      loadString(data_dir + "shaders/default_instanced.frag.glsl");
+  default_instanced_program_ = std::make_shared<Program>(
+      default_instanced_vs_source, default_instanced_fs_source);
+  flat_instanced_program_ =
+      std::make_shared<Program>(default_instanced_vs_source, flat_fs_source);
+  std::string depth_instanced_vs_source =
+      loadString(data_dir + "shaders/depth_instanced.vert.glsl");
+  depth_instanced_program_ = std::make_shared<Program>(
+      depth_instanced_vs_source, /*fragment_shader_source=*/"");
+
+  // Create meshes; text and heightfield meshes are built and cached on
+  // first use
+  box_mesh_ = mesh_cache_.get(MeshCache::PrimitiveType::BOX);
+  tube_mesh_ = mesh_cache_.get(MeshCache::PrimitiveType::TUBE,
+                               /*n_segments=*/32);
+  capsule_end_mesh_ = mesh_cache_.get(MeshCache::PrimitiveType::CAPSULE_END,
+                                      /*n_segments=*/32, /*n_rings=*/8);
+  cylinder_end_mesh_ = mesh_cache_.get(MeshCache::PrimitiveType::CYLINDER_END,
+                                       /*n_segments=*/32);
+
+  // Create instance buffers and record their layouts into the mesh vertex
+  // arrays, so each link mesh can be drawn with one instanced call
+  box_instance_buffer_ = std::make_shared<InstanceBuffer>();
+  box_instance_buffer_->bindToMesh(*box_mesh_);
+  tube_instance_buffer_ = std::make_shared<InstanceBuffer>();
+  tube_instance_buffer_->bindToMesh(*tube_mesh_);
+  capsule_end_instance_buffer_ = std::make_shared<InstanceBuffer>();
+  capsule_end_instance_buffer_->bindToMesh(*capsule_end_mesh_);
+  cylinder_end_instance_buffer_ = std::make_shared<InstanceBuffer>();
+  cylinder_end_instance_buffer_->bindToMesh(*cylinder_end_mesh_);
 
   // Create directional light
   dir_light_ = std::make_shared<DirectionalLight>(
@@ -74,26 +100,46 @@ void GLRenderer::render(const Simulation &sim,
                         const CameraParameters &camera_params,
                         const RenderParameters &render_params, int width,
                         int height, const Framebuffer *target_framebuffer) {
+  scene_snapshot_.capture(sim, /*time=*/0.0);
+  render(scene_snapshot_, camera_params, render_params, width, height,
+         target_framebuffer);
+}
+
+void GLRenderer::render(const SimulationSnapshot &snapshot,
+                        const CameraParameters &camera_params,
+                        const RenderParameters &render_params, int width,
+                        int height, const Framebuffer *target_framebuffer) {
   Eigen::Matrix4f proj_matrix = camera_params.getProjMatrix();
   Eigen::Matrix4f view_matrix = camera_params.getViewMatrix();
   dir_light_->updateViewMatricesAndSplits(
       view_matrix, camera_params.aspect_ratio_, camera_params.z_near_,
       camera_params.z_far_, camera_params.fov_);
 
+  // Collect the robot link instances once; every pass below reuses them
+  collectLinkInstances(snapshot);
+
   // Render shadow maps
   dir_light_->sm_framebuffer_->bind();
   glViewport(0, 0, dir_light_->sm_width_, dir_light_->sm_height_);
   glEnable(GL_POLYGON_OFFSET_FILL);
-  depth_program_->use();
   ProgramState depth_program_state;
+  ProgramState depth_instanced_program_state;
+  depth_instanced_program_state.setModelMatrix(Eigen::Matrix4f::Identity());
   for (int i = 0; i < dir_light_->sm_cascade_count_; ++i) {
     dir_light_->sm_framebuffer_->attachDepthTextureLayer(
         *dir_light_->sm_depth_array_texture_, i);
     glClear(GL_DEPTH_BUFFER_BIT);
+    depth_instanced_program_->use();
+    depth_instanced_program_state.setProjectionMatrix(dir_light_->proj_matrix_);
+    depth_instanced_program_state.setViewMatrix(
+        dir_light_->view_matrices_.block<4, 4>(0, 4 * i));
+    drawLinkInstances(*depth_instanced_program_,
+                      depth_instanced_program_state);
+    depth_program_->use();
     depth_program_state.setProjectionMatrix(dir_light_->proj_matrix_);
     depth_program_state.setViewMatrix(
         dir_light_->view_matrices_.block<4, 4>(0, 4 * i));
-    drawOpaque(sim, *depth_program_, depth_program_state);
+    drawProps(snapshot, *depth_program_, depth_program_state);
   }
   glDisable(GL_POLYGON_OFFSET_FILL);
 
@@ -112,22 +158,39 @@ void GLRenderer::render(const Simulation &sim,
   // Render object outlines
   glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
   glEnable(GL_CULL_FACE);
+  flat_instanced_program_->use();
+  ProgramState flat_instanced_program_state;
+  flat_instanced_program_state.setProjectionMatrix(proj_matrix);
+  flat_instanced_program_state.setViewMatrix(view_matrix);
+  flat_instanced_program_state.setModelMatrix(Eigen::Matrix4f::Identity());
+  drawLinkInstances(*flat_instanced_program_, flat_instanced_program_state);
   flat_program_->use();
   ProgramState flat_program_state;
   flat_program_state.setProjectionMatrix(proj_matrix);
   flat_program_state.setViewMatrix(view_matrix);
-  drawOpaque(sim, *flat_program_, flat_program_state);
+  drawProps(snapshot, *flat_program_, flat_program_state);
   glDisable(GL_CULL_FACE);
   glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
   // Render objects with lighting and shadows
+  dir_light_->sm_depth_array_texture_->bind();
+  default_instanced_program_->use();
+  ProgramState default_instanced_program_state;
+  default_instanced_program_state.setProjectionMatrix(proj_matrix);
+  default_instanced_program_state.setViewMatrix(view_matrix);
+  // With an identity model matrix, the light "model-view" uniforms hold the
+  // raw light view matrices; the instanced shader applies the per-instance
+  // model matrix itself
+  default_instanced_program_state.setModelMatrix(Eigen::Matrix4f::Identity());
+  default_instanced_program_state.setDirectionalLight(*dir_light_);
+  drawLinkInstances(*default_instanced_program_,
+                    default_instanced_program_state);
   default_program_->use();
   ProgramState default_program_state;
   default_program_state.setProjectionMatrix(proj_matrix);
   default_program_state.setViewMatrix(view_matrix);
   default_program_state.setDirectionalLight(*dir_light_);
-  dir_light_->sm_depth_array_texture_->bind();
-  drawOpaque(sim, *default_program_, default_program_state);
+  drawProps(snapshot, *default_program_, default_program_state);
 
   // Render label text with depth testing/writing turned off
   glDisable(GL_DEPTH_TEST);
@@ -137,51 +200,50 @@ void GLRenderer::render(const Simulation &sim,
   msdf_program_state.setProjectionMatrix(proj_matrix);
   msdf_program_state.setViewMatrix(view_matrix);
   font_->page_textures_.at(0)->bind();
-  drawLabels(sim, *msdf_program_, msdf_program_state);
+  drawLabels(snapshot, *msdf_program_, msdf_program_state);
   glDepthMask(GL_TRUE);
   glEnable(GL_DEPTH_TEST);
 }
 
-void GLRenderer::drawOpaque(const Simulation &sim, const Program &program,
-                            ProgramState &program_state) const {
-  // Draw robots
-  for (Index robot_idx = 0; robot_idx < sim.getRobotCount(); ++robot_idx) {
-    const Robot &robot = *sim.getRobot(robot_idx);
+void GLRenderer::collectLinkInstances(const SimulationSnapshot &snapshot) {
+  box_instances_.clear();
+  tube_instances_.clear();
+  capsule_end_instances_.clear();
+  cylinder_end_instances_.clear();
+
+  for (std::size_t robot_idx = 0; robot_idx < snapshot.robots_.size();
+       ++robot_idx) {
+    const Robot &robot = *snapshot.robots_[robot_idx];
     for (std::size_t link_idx = 0; link_idx < robot.links_.size(); ++link_idx) {
       const Link &link = robot.links_[link_idx];
-      Matrix4 link_transform;
-      sim.getLinkTransform(robot_idx, link_idx, link_transform);
+      Eigen::Matrix4f link_transform =
+          snapshot.link_transforms_[robot_idx][link_idx].matrix();
 
-      // Draw the link's collision shape
-      if (link.shape_ == LinkShape::CYLINDER) {
-        // Checkerboard (YZ) texture for cylinders
-        program_state.setProcTextureType(1);
-      } else {
-        // No texture for other shapes
-        program_state.setProcTextureType(0);
-      }
-      program_state.setObjectColor(link.color_);
+      // Collect the link's collision shape
+      // Checkerboard (YZ) texture for cylinders, no texture for other shapes
+      int proc_texture_type = (link.shape_ == LinkShape::CYLINDER) ? 1 : 0;
       switch (link.shape_) {
       case LinkShape::CAPSULE:
-        drawCapsule(link_transform.cast<float>(), link.length_ / 2,
-                    link.radius_, program, program_state);
+        addTubeBasedShapeInstances(capsule_end_instances_, link_transform,
+                                   link.length_ / 2, link.radius_, link.color_,
+                                   proc_texture_type);
         break;
       case LinkShape::CYLINDER:
-        drawCylinder(link_transform.cast<float>(), link.length_ / 2,
-                     link.radius_, program, program_state);
+        addTubeBasedShapeInstances(cylinder_end_instances_, link_transform,
+                                   link.length_ / 2, link.radius_, link.color_,
+                                   proc_texture_type);
         break;
       default:
         throw std::runtime_error("Unexpected link shape");
       }
 
-      // Draw the link's joint
-      program_state.setProcTextureType(0); // No texture
-      program_state.setObjectColor(link.joint_color_);
-      Matrix3 joint_axis_rotation(
-          Quaternion::FromTwoVectors(link.joint_axis_, Vector3::UnitX()));
-      Matrix4 joint_transform =
-          (Affine3(link_transform) * Translation3(-link.length_ / 2, 0, 0) *
-           Affine3(joint_axis_rotation))
+      // Collect the link's joint
+      Eigen::Matrix3f joint_axis_rotation(Eigen::Quaternionf::FromTwoVectors(
+          link.joint_axis_.cast<float>(), Eigen::Vector3f::UnitX()));
+      Eigen::Matrix4f joint_transform =
+          (Eigen::Affine3f(link_transform) *
+           Eigen::Translation3f(-link.length_ / 2, 0, 0) *
+           Eigen::Affine3f(joint_axis_rotation))
               .matrix();
 
       float joint_size;
@@ -198,24 +260,102 @@ void GLRenderer::drawOpaque(const Simulation &sim, const Program &program,
         // Nothing to draw
         break;
       case JointType::HINGE:
-        drawCylinder(joint_transform.cast<float>(), joint_size, joint_size,
-                     program, program_state);
+        addTubeBasedShapeInstances(cylinder_end_instances_, joint_transform,
+                                   joint_size, joint_size, link.joint_color_,
+                                   /*proc_texture_type=*/0);
         break;
-      case JointType::FIXED:
-        drawBox(joint_transform.cast<float>(),
-                Eigen::Vector3f::Constant(joint_size), program, program_state);
+      case JointType::FIXED: {
+        Eigen::Affine3f local_transform(
+            Eigen::Scaling(Eigen::Vector3f::Constant(joint_size)));
+        addMeshInstance(box_instances_,
+                        joint_transform * local_transform.matrix(),
+                        local_transform.matrix(), link.joint_color_,
+                        /*proc_texture_type=*/0);
         break;
+      }
       default:
         throw std::runtime_error("Unexpected joint type");
       }
     }
   }
 
+  // Stream this frame's instances into the persistent buffers
+  box_instance_buffer_->setData(box_instances_);
+  tube_instance_buffer_->setData(tube_instances_);
+  capsule_end_instance_buffer_->setData(capsule_end_instances_);
+  cylinder_end_instance_buffer_->setData(cylinder_end_instances_);
+}
+
+void GLRenderer::addMeshInstance(std::vector<MeshInstance> &instances,
+                                 const Eigen::Matrix4f &model_matrix,
+                                 const Eigen::Matrix4f &tex_coords_matrix,
+                                 const Eigen::Vector3f &color,
+                                 int proc_texture_type) {
+  instances.emplace_back();
+  MeshInstance &instance = instances.back();
+  Eigen::Map<Eigen::Matrix4f>(instance.model_matrix_.data()) = model_matrix;
+  Eigen::Map<Eigen::Matrix4f>(instance.tex_coords_matrix_.data()) =
+      tex_coords_matrix;
+  Eigen::Map<Eigen::Vector3f>(instance.color_.data()) = color;
+  instance.proc_texture_type_ = static_cast<GLfloat>(proc_texture_type);
+}
+
+void GLRenderer::addTubeBasedShapeInstances(
+    std::vector<MeshInstance> &end_instances, const Eigen::Matrix4f &transform,
+    float half_length, float radius, const Eigen::Vector3f &color,
+    int proc_texture_type) {
+  Eigen::Affine3f right_end_local_transform(
+      Eigen::Translation3f(half_length, 0, 0) *
+      Eigen::Scaling(radius, radius, radius));
+  addMeshInstance(end_instances,
+                  transform * right_end_local_transform.matrix(),
+                  right_end_local_transform.matrix(), color,
+                  proc_texture_type);
+
+  Eigen::Affine3f left_end_local_transform(
+      Eigen::Translation3f(-half_length, 0, 0) *
+      Eigen::Scaling(-radius, radius, -radius));
+  addMeshInstance(end_instances, transform * left_end_local_transform.matrix(),
+                  left_end_local_transform.matrix(), color,
+                  proc_texture_type);
+
+  Eigen::Affine3f middle_local_transform(
+      Eigen::Scaling(half_length, radius, radius));
+  addMeshInstance(tube_instances_, transform * middle_local_transform.matrix(),
+                  middle_local_transform.matrix(), color, proc_texture_type);
+}
+
+void GLRenderer::drawLinkInstances(const Program &program,
+                                   ProgramState &program_state) const {
+  // One instanced draw per primitive type
+  program_state.updateUniforms(program);
+  if (!box_instances_.empty()) {
+    box_mesh_->bind();
+    box_mesh_->drawInstanced(box_instances_.size());
+  }
+  if (!tube_instances_.empty()) {
+    tube_mesh_->bind();
+    tube_mesh_->drawInstanced(tube_instances_.size());
+  }
+  if (!capsule_end_instances_.empty()) {
+    capsule_end_mesh_->bind();
+    capsule_end_mesh_->drawInstanced(capsule_end_instances_.size());
+  }
+  if (!cylinder_end_instances_.empty()) {
+    cylinder_end_mesh_->bind();
+    cylinder_end_mesh_->drawInstanced(cylinder_end_instances_.size());
+  }
+}
+
+void GLRenderer::drawProps(const SimulationSnapshot &snapshot,
+                           const Program &program,
+                           ProgramState &program_state) {
   // Draw props
-  for (Index prop_idx = 0; prop_idx < sim.getPropCount(); ++prop_idx) {
-    const Prop &prop = *sim.getProp(prop_idx);
-    Matrix4 prop_transform;
-    sim.getPropTransform(prop_idx, prop_transform);
+  for (std::size_t prop_idx = 0; prop_idx < snapshot.props_.size();
+       ++prop_idx) {
+    const Prop &prop = *snapshot.props_[prop_idx];
+    Eigen::Matrix4f prop_transform =
+        snapshot.prop_transforms_[prop_idx].matrix();
 
     // Draw the prop's collision shape
     if (prop.density_ == 0.0 && prop_idx == 0) {
@@ -228,15 +368,46 @@ void GLRenderer::drawOpaque(const Simulation &sim, const Program &program,
     program_state.setObjectColor(prop.color_);
     switch (prop.shape_) {
     case PropShape::BOX:
-      drawBox(prop_transform.cast<float>(), prop.half_extents_.cast<float>(),
-              program, program_state);
+      drawBox(prop_transform, prop.half_extents_.cast<float>(), program,
+              program_state);
       break;
     case PropShape::HEIGHTFIELD: {
       const MatrixX &heightfield =
           dynamic_cast<const HeightfieldProp &>(prop).heightfield_;
-      drawHeightfield(prop_transform.cast<float>(),
-                      prop.half_extents_.cast<float>(), program, program_state,
-                      heightfield.cast<float>());
+      std::shared_ptr<Mesh> &mesh =
+          heightfield_mesh_cache_[snapshot.props_[prop_idx]];
+      if (!mesh) {
+        mesh = makeHeightfieldMesh(heightfield.cast<float>());
+      }
+      drawHeightfield(*mesh, prop_transform, prop.half_extents_.cast<float>(),
+                      heightfield.rows(), heightfield.cols(), program,
+                      program_state);
+      break;
+    }
+    case PropShape::TILED_HEIGHTFIELD: {
+      const TiledHeightfieldProp &tiled_prop =
+          dynamic_cast<const TiledHeightfieldProp &>(prop);
+      std::shared_ptr<Mesh> &mesh =
+          heightfield_mesh_cache_[snapshot.props_[prop_idx]];
+      // Preview mesh resolution is capped around 256 samples per side;
+      // collision tiles always use the full resolution
+      Eigen::Index stride = std::max<Eigen::Index>(
+          1, std::max(tiled_prop.rows(), tiled_prop.cols()) / 256);
+      Eigen::Index rows = (tiled_prop.rows() - 1) / stride + 1;
+      Eigen::Index cols = (tiled_prop.cols() - 1) / stride + 1;
+      if (!mesh) {
+        Eigen::MatrixXf heights(rows, cols);
+        for (Eigen::Index j = 0; j < cols; ++j) {
+          for (Eigen::Index i = 0; i < rows; ++i) {
+            heights(i, j) = static_cast<float>(tiled_prop.height(
+                std::min(i * stride, tiled_prop.rows() - 1),
+                std::min(j * stride, tiled_prop.cols() - 1)));
+          }
+        }
+        mesh = makeHeightfieldMesh(heights);
+      }
+      drawHeightfield(*mesh, prop_transform, prop.half_extents_.cast<float>(),
+                      rows, cols, program, program_state);
       break;
     }
     default:
@@ -245,29 +416,32 @@ void GLRenderer::drawOpaque(const Simulation &sim, const Program &program,
   }
 }
 
-void GLRenderer::drawLabels(const Simulation &sim, const Program &program,
-                            ProgramState &program_state) const {
+void GLRenderer::drawLabels(const SimulationSnapshot &snapshot,
+                            const Program &program,
+                            ProgramState &program_state) {
   // Draw robot labels
-  for (Index robot_idx = 0; robot_idx < sim.getRobotCount(); ++robot_idx) {
-    const Robot &robot = *sim.getRobot(robot_idx);
+  for (std::size_t robot_idx = 0; robot_idx < snapshot.robots_.size();
+       ++robot_idx) {
+    const Robot &robot = *snapshot.robots_[robot_idx];
     for (std::size_t link_idx = 0; link_idx < robot.links_.size(); ++link_idx) {
       const Link &link = robot.links_[link_idx];
-      Matrix4 link_transform;
-      sim.getLinkTransform(robot_idx, link_idx, link_transform);
+      Eigen::Matrix4f link_transform =
+          snapshot.link_transforms_[robot_idx][link_idx].matrix();
 
       // Draw the link's label, if it has one
       if (!link.label_.empty()) {
-        drawText(link_transform.cast<float>(), link.radius_, program,
-                 program_state, link.label_);
+        drawText(link_transform, link.radius_, program, program_state,
+                 link.label_);
       }
 
       // Draw the joint's label, if it has one
       if (!link.joint_label_.empty()) {
-        Matrix4 joint_transform =
-            (Affine3(link_transform) * Translation3(-link.length_ / 2, 0, 0))
+        Eigen::Matrix4f joint_transform =
+            (Eigen::Affine3f(link_transform) *
+             Eigen::Translation3f(-link.length_ / 2, 0, 0))
                 .matrix();
-        drawText(joint_transform.cast<float>(), link.radius_, program,
-                 program_state, link.joint_label_);
+        drawText(joint_transform, link.radius_, program, program_state,
+                 link.joint_label_);
       }
     }
   }
@@ -285,60 +459,33 @@ void GLRenderer::drawBox(const Eigen::Matrix4f &transform,
   box_mesh_->draw();
 }
 
-void GLRenderer::drawCapsule(const Eigen::Matrix4f &transform,
-                             float half_length, float radius,
-                             const Program &program,
-                             ProgramState &program_state) const {
-  drawTubeBasedShape(transform, half_length, radius, program, program_state,
-                     *capsule_end_mesh_);
-}
-
-void GLRenderer::drawCylinder(const Eigen::Matrix4f &transform,
-                              float half_length, float radius,
-                              const Program &program,
-                              ProgramState &program_state) const {
-  drawTubeBasedShape(transform, half_length, radius, program, program_state,
-                     *cylinder_end_mesh_);
-}
-
-void GLRenderer::drawTubeBasedShape(const Eigen::Matrix4f &transform,
-                                    float half_length, float radius,
-                                    const Program &program,
-                                    ProgramState &program_state,
-                                    const Mesh &end_mesh) const {
-  Eigen::Affine3f right_end_local_transform(
-      Eigen::Translation3f(half_length, 0, 0) *
-      Eigen::Scaling(radius, radius, radius));
-  end_mesh.bind();
-  program_state.setTexCoordsMatrix(right_end_local_transform.matrix());
-  program_state.setModelMatrix(transform * right_end_local_transform.matrix());
-  program_state.updateUniforms(program);
-  end_mesh.draw();
-
-  Eigen::Affine3f left_end_local_transform(
-      Eigen::Translation3f(-half_length, 0, 0) *
-      Eigen::Scaling(-radius, radius, -radius));
-  end_mesh.bind();
-  program_state.setTexCoordsMatrix(left_end_local_transform.matrix());
-  program_state.setModelMatrix(transform * left_end_local_transform.matrix());
-  program_state.updateUniforms(program);
-  end_mesh.draw();
-
-  Eigen::Affine3f middle_local_transform(
-      Eigen::Scaling(half_length, radius, radius));
-  tube_mesh_->bind();
-  program_state.setTexCoordsMatrix(middle_local_transform.matrix());
-  program_state.setModelMatrix(transform * middle_local_transform.matrix());
+void GLRenderer::drawText(const Eigen::Matrix4f &transform, float half_height,
+                          const Program &program, ProgramState &program_state,
+                          const std::string &str) {
+  std::shared_ptr<Mesh> text_mesh = getTextMesh(str);
+  // Glyph quads are cached at unit half-height; scale to the requested size
+  Eigen::Affine3f local_transform(
+      Eigen::Scaling(Eigen::Vector3f::Constant(half_height)));
+  text_mesh->bind();
+  program_state.setModelMatrix(transform * local_transform.matrix());
   program_state.updateUniforms(program);
-  tube_mesh_->draw();
+  text_mesh->draw();
 }
 
-void GLRenderer::drawText(const Eigen::Matrix4f &transform, float half_height,
-                          const Program &program, ProgramState &program_state,
-                          const std::string &str) const {
+std::shared_ptr<Mesh> GLRenderer::getTextMesh(const std::string &str) {
+  // Keep the cache bounded in case labels change every frame
+  if (text_mesh_cache_.size() >= 1024) {
+    text_mesh_cache_.clear();
+  }
+  std::shared_ptr<Mesh> &cached_mesh = text_mesh_cache_[str];
+  if (cached_mesh) {
+    return cached_mesh;
+  }
+
   std::vector<float> positions;
   std::vector<float> tex_coords;
   std::vector<int> indices;
+  constexpr float half_height = 1.0f;
   float xy_scale = 2.0f * half_height / font_->line_height_;
   float u_scale = 1.0f / font_->page_width_;
   float v_scale = 1.0f / font_->page_height_;
@@ -376,62 +523,29 @@ void GLRenderer::drawText(const Eigen::Matrix4f &transform, float half_height,
       j += 4;
     }
   }
-  text_mesh_->setPositions(positions);
-  text_mesh_->setTexCoords(tex_coords);
-  text_mesh_->setIndices(indices);
-
-  text_mesh_->bind();
-  program_state.setModelMatrix(transform.matrix());
-  program_state.updateUniforms(program);
-  text_mesh_->draw();
+  auto text_mesh = std::make_shared<Mesh>(/*usage=*/GL_STATIC_DRAW);
+  text_mesh->setPositions(positions);
+  text_mesh->setTexCoords(tex_coords);
+  text_mesh->setIndices(indices);
+  cached_mesh = text_mesh;
+  return text_mesh;
 }
 
-void GLRenderer::drawHeightfield(const Eigen::Matrix4f &transform,
-                                 const Eigen::Vector3f &half_extents,
-                                 const Program &program,
-                                 ProgramState &program_state,
-                                 const Eigen::MatrixXf &heightfield) const {
-  std::vector<float> positions;
-  std::vector<float> normals;
-  std::vector<int> indices;
-
-  for (int j = 0; j < heightfield.cols() - 1; ++j) {
-    for (int i = 0; i < heightfield.rows() - 1; ++i) {
-      Eigen::Vector3f p00(i, heightfield(i, j), j);
-      Eigen::Vector3f p10(i + 1, heightfield(i + 1, j), j);
-      Eigen::Vector3f p01(i, heightfield(i, j + 1), j + 1);
-      Eigen::Vector3f p11(i + 1, heightfield(i + 1, j + 1), j + 1);
-      Eigen::Vector3f n00 = (p01 - p00).cross(p10 - p00).normalized();
-      Eigen::Vector3f n11 = (p10 - p11).cross(p01 - p11).normalized();
-
-      Eigen::Vector<float, 18> pos;
-      pos << p00, p01, p10, p11, p10, p01;
-      Eigen::Vector<float, 18> nor;
-      nor << n00, n00, n00, n11, n11, n11;
-      Eigen::Vector<int, 6> idx;
-      idx << 0, 1, 2, 3, 4, 5;
-      idx += Eigen::Vector<int, 6>::Constant(indices.size());
-
-      positions.insert(positions.end(), std::begin(pos), std::end(pos));
-      normals.insert(normals.end(), std::begin(nor), std::end(nor));
-      indices.insert(indices.end(), std::begin(idx), std::end(idx));
-    }
-  }
-  heightfield_mesh_->setPositions(positions);
-  heightfield_mesh_->setNormals(normals);
-  heightfield_mesh_->setIndices(indices);
-
+void GLRenderer::drawHeightfield(const Mesh &mesh,
+                                 const Eigen::Matrix4f &transform,
+                                 const Eigen::Vector3f &half_extents, int rows,
+                                 int cols, const Program &program,
+                                 ProgramState &program_state) const {
   Eigen::Vector3f local_scaling =
       (2.0 * half_extents).array() /
-      Eigen::Vector3f(heightfield.rows() - 1, 1.0, heightfield.cols() - 1)
-          .array();
+      Eigen::Vector3f(rows - 1, 1.0, cols - 1).array();
   Eigen::Affine3f local_transform(Eigen::Translation3f(-half_extents) *
                                   Eigen::Scaling(local_scaling));
-  heightfield_mesh_->bind();
+  mesh.bind();
   program_state.setTexCoordsMatrix(local_transform.matrix());
   program_state.setModelMatrix(transform * local_transform.matrix());
   program_state.updateUniforms(program);
-  heightfield_mesh_->draw();
+  mesh.draw();
 }
 
 std::string GLRenderer::loadString(const std::string &path) {
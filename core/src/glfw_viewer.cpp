@@ -1,11 +1,14 @@
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <robot_design/glfw_viewer.h>
 #include <robot_design/render.h>
 #include <stdexcept>
+#include <thread>
 
 namespace robot_design {
 
@@ -89,6 +92,29 @@ bool FPSCameraController::shouldRecord() const {
   return action_flags_[ACTION_RECORD];
 }
 
+void SimulationSnapshotBuffer::publish(const SimulationSnapshot &prev,
+                                       const SimulationSnapshot &curr) {
+  Slot &slot = slots_[write_slot_];
+  slot.prev_ = prev;
+  slot.curr_ = curr;
+  write_slot_ = ready_slot_.exchange(write_slot_, std::memory_order_acq_rel);
+  fresh_.store(true, std::memory_order_release);
+}
+
+bool SimulationSnapshotBuffer::fetchLatest(const SimulationSnapshot *&prev,
+                                           const SimulationSnapshot *&curr) {
+  if (fresh_.exchange(false, std::memory_order_acquire)) {
+    read_slot_ = ready_slot_.exchange(read_slot_, std::memory_order_acq_rel);
+    read_valid_ = true;
+  }
+  if (!read_valid_) {
+    return false;
+  }
+  prev = &slots_[read_slot_].prev_;
+  curr = &slots_[read_slot_].curr_;
+  return true;
+}
+
 GLFWViewer::GLFWViewer(bool hidden) {
   glfwSetErrorCallback(errorCallback);
 
@@ -166,6 +192,77 @@ void GLFWViewer::setFramebufferSize(int width, int height) {
   glfwSetWindowSize(window_, width, height);
 }
 
+void GLFWViewer::run(Simulation &sim, const SimStepCallback &step_callback,
+                     double real_time_factor) {
+  using Clock = std::chrono::steady_clock;
+  using Seconds = std::chrono::duration<double>;
+
+  SimulationSnapshotBuffer snapshot_buffer;
+  std::atomic<bool> done(false);
+  double time_step = sim.getTimeStep();
+  Clock::time_point start_time = Clock::now();
+
+  std::thread sim_thread([&]() {
+    SimulationSnapshot prev_snapshot, curr_snapshot;
+    curr_snapshot.capture(sim, /*time=*/0.0);
+    prev_snapshot = curr_snapshot;
+    snapshot_buffer.publish(prev_snapshot, curr_snapshot);
+    double sim_time = 0.0;
+    int step_idx = 0;
+    while (!done) {
+      double target_time =
+          Seconds(Clock::now() - start_time).count() * real_time_factor;
+      while (sim_time < target_time && !done) {
+        step_callback(step_idx);
+        ++step_idx;
+        sim_time += time_step;
+        std::swap(prev_snapshot, curr_snapshot);
+        curr_snapshot.capture(sim, sim_time);
+        snapshot_buffer.publish(prev_snapshot, curr_snapshot);
+      }
+      // Sleep for a fraction of a step to avoid busy-waiting without
+      // falling a full step behind
+      std::this_thread::sleep_for(
+          Seconds(0.25 * time_step / real_time_factor));
+    }
+  });
+
+  SimulationSnapshot interp_snapshot;
+  const SimulationSnapshot *prev_snapshot = nullptr;
+  const SimulationSnapshot *curr_snapshot = nullptr;
+  Clock::time_point last_frame_time = start_time;
+  while (!shouldClose()) {
+    Clock::time_point frame_time = Clock::now();
+    update(Seconds(frame_time - last_frame_time).count());
+    last_frame_time = frame_time;
+
+    if (snapshot_buffer.fetchLatest(prev_snapshot, curr_snapshot)) {
+      // Interpolate between the two most recent states based on wall time
+      double render_time =
+          Seconds(frame_time - start_time).count() * real_time_factor;
+      double t = 1.0;
+      if (curr_snapshot->time_ > prev_snapshot->time_) {
+        t = (render_time - prev_snapshot->time_) /
+            (curr_snapshot->time_ - prev_snapshot->time_);
+        t = std::min(std::max(t, 0.0), 1.0);
+      }
+      SimulationSnapshot::interpolate(*prev_snapshot, *curr_snapshot, t,
+                                      interp_snapshot);
+
+      int width, height;
+      getFramebufferSize(width, height);
+      camera_params_.aspect_ratio_ = static_cast<float>(width) / height;
+      renderer_->render(interp_snapshot, camera_params_, render_params_, width,
+                        height);
+      glfwSwapBuffers(window_);
+    }
+    glfwPollEvents();
+  }
+
+  done = true;
+  sim_thread.join();
+}
+
 bool GLFWViewer::shouldClose() const { return glfwWindowShouldClose(window_); }
 
 void GLFWViewer::errorCallback(int error, const char *description) {
@@ -3,6 +3,7 @@
 #include <deque>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <robot_design/graph.h>
 #include <robot_design/robot.h>
 #include <stdexcept>
@@ -118,4 +119,43 @@ Robot buildRobot(const Graph &graph) {
   return robot;
 }
 
+RobotCache::RobotCache(std::size_t capacity) : capacity_(capacity) {
+  assert(capacity >= 1);
+}
+
+std::shared_ptr<const Robot> RobotCache::get(const Graph &graph) {
+  std::size_t digest = hashGraph(graph);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = lookup_.find(digest);
+    if (it != lookup_.end()) {
+      // Move the entry to the front (most recently used)
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+  }
+
+  // Build outside the lock so concurrent misses do not serialize
+  auto robot = std::make_shared<const Robot>(buildRobot(graph));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto result = lookup_.emplace(digest, entries_.end());
+  if (!result.second) {
+    // Another thread built the same robot first, reuse its entry
+    return result.first->second->second;
+  }
+  entries_.emplace_front(digest, robot);
+  result.first->second = entries_.begin();
+  if (entries_.size() > capacity_) {
+    lookup_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return robot;
+}
+
+std::shared_ptr<const Robot> buildRobotCached(const Graph &graph) {
+  static RobotCache robot_cache;
+  return robot_cache.get(graph);
+}
+
 } // namespace robot_design
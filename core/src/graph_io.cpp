@@ -1,6 +1,10 @@
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <robot_design/graph.h>
 #include <robot_design/internal/dot_parsing.h>
@@ -10,13 +14,109 @@
 #include <sstream>
 #include <stdexcept>
 #include <tao/pegtl.hpp>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace robot_design {
 
 constexpr Scalar RAD_PER_DEG = M_PI / 180;
 
-std::vector<Graph> loadGraphs(const std::string &path) {
+namespace {
+
+// Binary graph format: magic, version, then length-prefixed strings and raw
+// scalar fields in declaration order (little-endian on all supported targets)
+constexpr char GRAPH_BINARY_MAGIC[4] = {'R', 'D', 'G', 'B'};
+constexpr std::uint32_t GRAPH_BINARY_VERSION = 1;
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>
+writeBinary(std::ostream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void writeBinary(std::ostream &out, const std::string &str) {
+  std::uint64_t size = str.size();
+  out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  out.write(str.data(), size);
+}
+
+void writeBinary(std::ostream &out, const Color &color) {
+  out.write(reinterpret_cast<const char *>(color.data()),
+            3 * sizeof(float));
+}
+
+void writeBinary(std::ostream &out, const Vector3 &vec) {
+  out.write(reinterpret_cast<const char *>(vec.data()), 3 * sizeof(Scalar));
+}
+
+void writeBinary(std::ostream &out, const Quaternion &quat) {
+  out.write(reinterpret_cast<const char *>(quat.coeffs().data()),
+            4 * sizeof(Scalar));
+}
+
+void writeBinary(std::ostream &out, const std::set<NodeIndex> &indices) {
+  std::uint64_t size = indices.size();
+  out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  for (NodeIndex idx : indices) {
+    writeBinary(out, idx);
+  }
+}
+
+// Parses the in-memory file image with bounds checking
+struct BinaryReader {
+  BinaryReader(const char *data, std::size_t size)
+      : data_(data), size_(size) {}
+
+  void readBytes(void *dest, std::size_t count) {
+    if (offset_ + count > size_) {
+      throw std::runtime_error("Binary graph file is truncated");
+    }
+    std::memcpy(dest, data_ + offset_, count);
+    offset_ += count;
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>
+  read(T &value) {
+    readBytes(&value, sizeof(T));
+  }
+
+  void read(std::string &str) {
+    std::uint64_t size;
+    read(size);
+    if (offset_ + size > size_) {
+      throw std::runtime_error("Binary graph file is truncated");
+    }
+    str.assign(data_ + offset_, size);
+    offset_ += size;
+  }
+
+  void read(Color &color) { readBytes(color.data(), 3 * sizeof(float)); }
+
+  void read(Vector3 &vec) { readBytes(vec.data(), 3 * sizeof(Scalar)); }
+
+  void read(Quaternion &quat) {
+    readBytes(quat.coeffs().data(), 4 * sizeof(Scalar));
+  }
+
+  void read(std::set<NodeIndex> &indices) {
+    std::uint64_t size;
+    read(size);
+    indices.clear();
+    for (std::uint64_t i = 0; i < size; ++i) {
+      NodeIndex idx;
+      read(idx);
+      indices.insert(indices.end(), idx);
+    }
+  }
+
+  const char *data_;
+  std::size_t size_;
+  std::size_t offset_ = 0;
+};
+
+std::vector<Graph> parseGraphs(const std::string &path) {
   tao::pegtl::file_input<> input(path);
   std::vector<Graph> graphs;
   bool success;
@@ -36,6 +136,142 @@ std::vector<Graph> loadGraphs(const std::string &path) {
   return graphs;
 }
 
+} // namespace
+
+std::vector<Graph> loadGraphs(const std::string &path) {
+  namespace fs = std::filesystem;
+  std::string cache_path = path + "c";
+  std::error_code src_ec, cache_ec;
+  auto src_time = fs::last_write_time(path, src_ec);
+  auto cache_time = fs::last_write_time(cache_path, cache_ec);
+  if (!src_ec && !cache_ec && cache_time >= src_time) {
+    try {
+      return loadGraphsBinary(cache_path);
+    } catch (const std::exception &) {
+      // Stale or corrupt cache, fall through and reparse the source
+    }
+  }
+
+  std::vector<Graph> graphs = parseGraphs(path);
+
+  try {
+    saveGraphsBinary(graphs, cache_path);
+  } catch (const std::exception &) {
+    // Caching is best-effort, e.g. the data directory may be read-only
+  }
+
+  return graphs;
+}
+
+void saveGraphsBinary(const std::vector<Graph> &graphs,
+                      const std::string &path) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Could not open file \"" + path +
+                             "\" for writing");
+  }
+
+  out.write(GRAPH_BINARY_MAGIC, sizeof(GRAPH_BINARY_MAGIC));
+  writeBinary(out, GRAPH_BINARY_VERSION);
+  writeBinary(out, static_cast<std::uint64_t>(graphs.size()));
+  for (const Graph &graph : graphs) {
+    writeBinary(out, graph.name_);
+    writeBinary(out, static_cast<std::uint64_t>(graph.nodes_.size()));
+    for (const Node &node : graph.nodes_) {
+      writeBinary(out, node.name_);
+      NodeAttributes::accept([&](auto &&value) { writeBinary(out, value); },
+                             node.attrs_);
+    }
+    writeBinary(out, static_cast<std::uint64_t>(graph.edges_.size()));
+    for (const Edge &edge : graph.edges_) {
+      writeBinary(out, edge.head_);
+      writeBinary(out, edge.tail_);
+      EdgeAttributes::accept([&](auto &&value) { writeBinary(out, value); },
+                             edge.attrs_);
+    }
+    writeBinary(out, static_cast<std::uint64_t>(graph.subgraphs_.size()));
+    for (const Subgraph &subgraph : graph.subgraphs_) {
+      writeBinary(out, subgraph.name_);
+      writeBinary(out, subgraph.nodes_);
+      writeBinary(out, subgraph.edges_);
+      NodeAttributes::accept([&](auto &&value) { writeBinary(out, value); },
+                             subgraph.node_attrs_);
+      EdgeAttributes::accept([&](auto &&value) { writeBinary(out, value); },
+                             subgraph.edge_attrs_);
+    }
+  }
+
+  if (!out) {
+    throw std::runtime_error("Failed to write file \"" + path + "\"");
+  }
+}
+
+std::vector<Graph> loadGraphsBinary(const std::string &path) {
+  // One bulk read of the whole file, everything else parses from memory
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::runtime_error("Could not open file \"" + path +
+                             "\" for reading");
+  }
+  std::streamsize size = in.tellg();
+  in.seekg(0);
+  std::vector<char> buffer(size);
+  if (!in.read(buffer.data(), size)) {
+    throw std::runtime_error("Failed to read file \"" + path + "\"");
+  }
+
+  BinaryReader reader(buffer.data(), buffer.size());
+  char magic[sizeof(GRAPH_BINARY_MAGIC)];
+  reader.readBytes(magic, sizeof(magic));
+  if (std::memcmp(magic, GRAPH_BINARY_MAGIC, sizeof(magic)) != 0) {
+    throw std::runtime_error("File \"" + path +
+                             "\" is not a binary graph file");
+  }
+  std::uint32_t version;
+  reader.read(version);
+  if (version != GRAPH_BINARY_VERSION) {
+    throw std::runtime_error("Unsupported binary graph file version");
+  }
+
+  std::uint64_t graph_count;
+  reader.read(graph_count);
+  std::vector<Graph> graphs(graph_count);
+  for (Graph &graph : graphs) {
+    reader.read(graph.name_);
+    std::uint64_t node_count;
+    reader.read(node_count);
+    graph.nodes_.resize(node_count);
+    for (Node &node : graph.nodes_) {
+      reader.read(node.name_);
+      NodeAttributes::accept([&](auto &value) { reader.read(value); },
+                             node.attrs_);
+    }
+    std::uint64_t edge_count;
+    reader.read(edge_count);
+    graph.edges_.resize(edge_count);
+    for (Edge &edge : graph.edges_) {
+      reader.read(edge.head_);
+      reader.read(edge.tail_);
+      EdgeAttributes::accept([&](auto &value) { reader.read(value); },
+                             edge.attrs_);
+    }
+    std::uint64_t subgraph_count;
+    reader.read(subgraph_count);
+    graph.subgraphs_.resize(subgraph_count);
+    for (Subgraph &subgraph : graph.subgraphs_) {
+      reader.read(subgraph.name_);
+      reader.read(subgraph.nodes_);
+      reader.read(subgraph.edges_);
+      NodeAttributes::accept([&](auto &value) { reader.read(value); },
+                             subgraph.node_attrs_);
+      EdgeAttributes::accept([&](auto &value) { reader.read(value); },
+                             subgraph.edge_attrs_);
+    }
+  }
+
+  return graphs;
+}
+
 static bool parseDOTBool(const std::string &str) {
   // TODO: add case insensitivity
   if (str == "true" || str == "yes") {
@@ -50,44 +286,218 @@ static bool parseDOTBool(const std::string &str) {
   }
 }
 
+NodeAttributeKey lookupNodeAttributeKey(const std::string &key) {
+  static const std::unordered_map<std::string, NodeAttributeKey> KEY_MAP = {
+      {"label", NodeAttributeKey::LABEL},
+      {"shape", NodeAttributeKey::SHAPE},
+      {"length", NodeAttributeKey::LENGTH},
+      {"radius", NodeAttributeKey::RADIUS},
+      {"density", NodeAttributeKey::DENSITY},
+      {"friction", NodeAttributeKey::FRICTION},
+      {"base", NodeAttributeKey::BASE},
+      {"color", NodeAttributeKey::COLOR},
+      {"require_label", NodeAttributeKey::REQUIRE_LABEL}};
+  auto elem = KEY_MAP.find(key);
+  return (elem != KEY_MAP.end()) ? elem->second : NodeAttributeKey::UNKNOWN;
+}
+
+EdgeAttributeKey lookupEdgeAttributeKey(const std::string &key) {
+  static const std::unordered_map<std::string, EdgeAttributeKey> KEY_MAP = {
+      {"id", EdgeAttributeKey::ID},
+      {"label", EdgeAttributeKey::LABEL},
+      {"type", EdgeAttributeKey::TYPE},
+      {"offset", EdgeAttributeKey::OFFSET},
+      {"axis_angle", EdgeAttributeKey::AXIS_ANGLE},
+      {"joint_axis", EdgeAttributeKey::JOINT_AXIS},
+      {"kp", EdgeAttributeKey::KP},
+      {"kd", EdgeAttributeKey::KD},
+      {"torque", EdgeAttributeKey::TORQUE},
+      {"limits", EdgeAttributeKey::LIMITS},
+      {"control_mode", EdgeAttributeKey::CONTROL_MODE},
+      {"scale", EdgeAttributeKey::SCALE},
+      {"mirror", EdgeAttributeKey::MIRROR},
+      {"color", EdgeAttributeKey::COLOR},
+      {"require_label", EdgeAttributeKey::REQUIRE_LABEL}};
+  auto elem = KEY_MAP.find(key);
+  return (elem != KEY_MAP.end()) ? elem->second : EdgeAttributeKey::UNKNOWN;
+}
+
+namespace {
+
+// The switch over the interned key compiles to an indexed jump; unknown
+// keys are ignored, as before
+void applyNodeAttribute(NodeAttributes &node_attrs, NodeAttributeKey key,
+                        const std::string &value) {
+  switch (key) {
+  case NodeAttributeKey::LABEL:
+    node_attrs.label_ = value;
+    break;
+  case NodeAttributeKey::SHAPE:
+    if (value == "capsule") {
+      node_attrs.shape_ = LinkShape::CAPSULE;
+    } else if (value == "cylinder") {
+      node_attrs.shape_ = LinkShape::CYLINDER;
+    } else {
+      throw std::runtime_error("Unexpected value \"" + value +
+                               "\" for link_shape");
+    }
+    break;
+  case NodeAttributeKey::LENGTH: {
+    std::istringstream in(value);
+    in >> node_attrs.length_;
+    break;
+  }
+  case NodeAttributeKey::RADIUS: {
+    std::istringstream in(value);
+    in >> node_attrs.radius_;
+    break;
+  }
+  case NodeAttributeKey::DENSITY: {
+    std::istringstream in(value);
+    in >> node_attrs.density_;
+    break;
+  }
+  case NodeAttributeKey::FRICTION: {
+    std::istringstream in(value);
+    in >> node_attrs.friction_;
+    break;
+  }
+  case NodeAttributeKey::BASE:
+    node_attrs.base_ = parseDOTBool(value);
+    break;
+  case NodeAttributeKey::COLOR: {
+    std::istringstream in(value);
+    Color &color = node_attrs.color_;
+    in >> color(0) >> color(1) >> color(2);
+    break;
+  }
+  case NodeAttributeKey::REQUIRE_LABEL:
+    node_attrs.require_label_ = value;
+    break;
+  default:
+    break;
+  }
+}
+
+void applyEdgeAttribute(EdgeAttributes &edge_attrs, EdgeAttributeKey key,
+                        const std::string &value) {
+  switch (key) {
+  case EdgeAttributeKey::ID:
+    edge_attrs.id_ = value;
+    break;
+  case EdgeAttributeKey::LABEL:
+    edge_attrs.label_ = value;
+    break;
+  case EdgeAttributeKey::TYPE:
+    if (value == "none") {
+      edge_attrs.joint_type_ = JointType::NONE;
+    } else if (value == "free") {
+      edge_attrs.joint_type_ = JointType::FREE;
+    } else if (value == "hinge") {
+      edge_attrs.joint_type_ = JointType::HINGE;
+    } else if (value == "fixed") {
+      edge_attrs.joint_type_ = JointType::FIXED;
+    } else {
+      throw std::runtime_error("Unexpected value \"" + value +
+                               "\" for joint_type");
+    }
+    break;
+  case EdgeAttributeKey::OFFSET: {
+    std::istringstream in(value);
+    in >> edge_attrs.joint_pos_;
+    break;
+  }
+  case EdgeAttributeKey::AXIS_ANGLE: {
+    std::istringstream in(value);
+    Vector3 axis;
+    Scalar angle;
+    in >> axis(0) >> axis(1) >> axis(2) >> angle;
+    edge_attrs.joint_rot_ = Eigen::AngleAxis<Scalar>(angle * RAD_PER_DEG, axis);
+    break;
+  }
+  case EdgeAttributeKey::JOINT_AXIS: {
+    std::istringstream in(value);
+    Vector3 &joint_axis = edge_attrs.joint_axis_;
+    in >> joint_axis(0) >> joint_axis(1) >> joint_axis(2);
+    break;
+  }
+  case EdgeAttributeKey::KP: {
+    std::istringstream in(value);
+    in >> edge_attrs.joint_kp_;
+    break;
+  }
+  case EdgeAttributeKey::KD: {
+    std::istringstream in(value);
+    in >> edge_attrs.joint_kd_;
+    break;
+  }
+  case EdgeAttributeKey::TORQUE: {
+    std::istringstream in(value);
+    in >> edge_attrs.joint_torque_;
+    break;
+  }
+  case EdgeAttributeKey::LIMITS: {
+    std::istringstream in(value);
+    Scalar lower_limit, upper_limit;
+    in >> lower_limit >> upper_limit;
+    edge_attrs.joint_lower_limit_ = lower_limit * RAD_PER_DEG;
+    edge_attrs.joint_upper_limit_ = upper_limit * RAD_PER_DEG;
+    break;
+  }
+  case EdgeAttributeKey::CONTROL_MODE:
+    if (value == "position") {
+      edge_attrs.joint_control_mode_ = JointControlMode::POSITION;
+    } else if (value == "velocity") {
+      edge_attrs.joint_control_mode_ = JointControlMode::VELOCITY;
+    } else {
+      throw std::runtime_error("Unexpected value \"" + value +
+                               "\" for control_mode");
+    }
+    break;
+  case EdgeAttributeKey::SCALE: {
+    std::istringstream in(value);
+    in >> edge_attrs.scale_;
+    break;
+  }
+  case EdgeAttributeKey::MIRROR:
+    edge_attrs.mirror_ = parseDOTBool(value);
+    break;
+  case EdgeAttributeKey::COLOR: {
+    std::istringstream in(value);
+    Color &color = edge_attrs.color_;
+    in >> color(0) >> color(1) >> color(2);
+    break;
+  }
+  case EdgeAttributeKey::REQUIRE_LABEL:
+    edge_attrs.require_label_ = value;
+    break;
+  default:
+    break;
+  }
+}
+
+} // namespace
+
+void updateNodeAttributes(NodeAttributes &node_attrs,
+                          const std::vector<DotAttribute> &attr_list) {
+  for (const DotAttribute &attr : attr_list) {
+    applyNodeAttribute(node_attrs, attr.node_key_, attr.value_);
+  }
+}
+
+void updateEdgeAttributes(EdgeAttributes &edge_attrs,
+                          const std::vector<DotAttribute> &attr_list) {
+  for (const DotAttribute &attr : attr_list) {
+    applyEdgeAttribute(edge_attrs, attr.edge_key_, attr.value_);
+  }
+}
+
 void updateNodeAttributes(
     NodeAttributes &node_attrs,
     const std::vector<std::pair<std::string, std::string>> &attr_list) {
   for (const auto &attr : attr_list) {
-    const std::string &key = attr.first;
-    const std::string &value = attr.second;
-    if (key == "label") {
-      node_attrs.label_ = value;
-    } else if (key == "shape") {
-      if (value == "capsule") {
-        node_attrs.shape_ = LinkShape::CAPSULE;
-      } else if (value == "cylinder") {
-        node_attrs.shape_ = LinkShape::CYLINDER;
-      } else {
-        throw std::runtime_error("Unexpected value \"" + value +
-                                 "\" for link_shape");
-      }
-    } else if (key == "length") {
-      std::istringstream in(value);
-      in >> node_attrs.length_;
-    } else if (key == "radius") {
-      std::istringstream in(value);
-      in >> node_attrs.radius_;
-    } else if (key == "density") {
-      std::istringstream in(value);
-      in >> node_attrs.density_;
-    } else if (key == "friction") {
-      std::istringstream in(value);
-      in >> node_attrs.friction_;
-    } else if (key == "base") {
-      node_attrs.base_ = parseDOTBool(value);
-    } else if (key == "color") {
-      std::istringstream in(value);
-      Color &color = node_attrs.color_;
-      in >> color(0) >> color(1) >> color(2);
-    } else if (key == "require_label") {
-      node_attrs.require_label_ = value;
-    }
+    applyNodeAttribute(node_attrs, lookupNodeAttributeKey(attr.first),
+                       attr.second);
   }
 }
 
@@ -95,75 +505,8 @@ void updateEdgeAttributes(
     EdgeAttributes &edge_attrs,
     const std::vector<std::pair<std::string, std::string>> &attr_list) {
   for (const auto &attr : attr_list) {
-    const std::string &key = attr.first;
-    const std::string &value = attr.second;
-    if (key == "id") {
-      edge_attrs.id_ = value;
-    } else if (key == "label") {
-      edge_attrs.label_ = value;
-    } else if (key == "type") {
-      if (value == "none") {
-        edge_attrs.joint_type_ = JointType::NONE;
-      } else if (value == "free") {
-        edge_attrs.joint_type_ = JointType::FREE;
-      } else if (value == "hinge") {
-        edge_attrs.joint_type_ = JointType::HINGE;
-      } else if (value == "fixed") {
-        edge_attrs.joint_type_ = JointType::FIXED;
-      } else {
-        throw std::runtime_error("Unexpected value \"" + value +
-                                 "\" for joint_type");
-      }
-    } else if (key == "offset") {
-      std::istringstream in(value);
-      in >> edge_attrs.joint_pos_;
-    } else if (key == "axis_angle") {
-      std::istringstream in(value);
-      Vector3 axis;
-      Scalar angle;
-      in >> axis(0) >> axis(1) >> axis(2) >> angle;
-      edge_attrs.joint_rot_ =
-          Eigen::AngleAxis<Scalar>(angle * RAD_PER_DEG, axis);
-    } else if (key == "joint_axis") {
-      std::istringstream in(value);
-      Vector3 &joint_axis = edge_attrs.joint_axis_;
-      in >> joint_axis(0) >> joint_axis(1) >> joint_axis(2);
-    } else if (key == "kp") {
-      std::istringstream in(value);
-      in >> edge_attrs.joint_kp_;
-    } else if (key == "kd") {
-      std::istringstream in(value);
-      in >> edge_attrs.joint_kd_;
-    } else if (key == "torque") {
-      std::istringstream in(value);
-      in >> edge_attrs.joint_torque_;
-    } else if (key == "limits") {
-      std::istringstream in(value);
-      Scalar lower_limit, upper_limit;
-      in >> lower_limit >> upper_limit;
-      edge_attrs.joint_lower_limit_ = lower_limit * RAD_PER_DEG;
-      edge_attrs.joint_upper_limit_ = upper_limit * RAD_PER_DEG;
-    } else if (key == "control_mode") {
-      if (value == "position") {
-        edge_attrs.joint_control_mode_ = JointControlMode::POSITION;
-      } else if (value == "velocity") {
-        edge_attrs.joint_control_mode_ = JointControlMode::VELOCITY;
-      } else {
-        throw std::runtime_error("Unexpected value \"" + value +
-                                 "\" for control_mode");
-      }
-    } else if (key == "scale") {
-      std::istringstream in(value);
-      in >> edge_attrs.scale_;
-    } else if (key == "mirror") {
-      edge_attrs.mirror_ = parseDOTBool(value);
-    } else if (key == "color") {
-      std::istringstream in(value);
-      Color &color = edge_attrs.color_;
-      in >> color(0) >> color(1) >> color(2);
-    } else if (key == "require_label") {
-      edge_attrs.require_label_ = value;
-    }
+    applyEdgeAttribute(edge_attrs, lookupEdgeAttributeKey(attr.first),
+                       attr.second);
   }
 }
 
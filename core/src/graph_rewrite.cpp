@@ -1,13 +1,62 @@
+#include <ThreadPool.h>
 #include <algorithm>
 #include <iterator>
 #include <robot_design/graph.h>
+#include <robot_design/perf.h>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace robot_design {
 
+std::size_t hashGraph(const Graph &graph) {
+  if (graph.cached_hash_valid_) {
+    return graph.cached_hash_;
+  }
+
+  std::size_t seed = 0;
+  hashCombine(seed, graph.name_);
+
+  // Hash each node's and edge's attributes exactly once, the per-node
+  // incident edge sums are accumulated in a single pass over the edges
+  std::vector<std::size_t> node_hashes(graph.nodes_.size());
+  for (NodeIndex i = 0; i < graph.nodes_.size(); ++i) {
+    node_hashes[i] = std::hash<Node>()(graph.nodes_[i]);
+  }
+  std::vector<std::size_t> head_node_seeds(graph.nodes_.size(), 0);
+  std::vector<std::size_t> tail_node_seeds(graph.nodes_.size(), 0);
+  std::size_t edges_seed = 0;
+  for (const Edge &edge : graph.edges_) {
+    std::size_t edge_attrs_hash = std::hash<EdgeAttributes>()(edge.attrs_);
+    head_node_seeds[edge.head_] += edge_attrs_hash;
+    tail_node_seeds[edge.tail_] += edge_attrs_hash;
+    // Hash edges (order should not matter)
+    std::size_t edge_seed = 0;
+    hashCombine(edge_seed, node_hashes[edge.head_]);
+    hashCombine(edge_seed, node_hashes[edge.tail_]);
+    hashCombine(edge_seed, edge_attrs_hash);
+    edges_seed += edge_seed;
+  }
+
+  // Hash nodes (order should not matter)
+  std::size_t nodes_seed = 0;
+  for (NodeIndex i = 0; i < graph.nodes_.size(); ++i) {
+    std::size_t node_seed = node_hashes[i];
+    hashCombine(node_seed, head_node_seeds[i]);
+    hashCombine(node_seed, tail_node_seeds[i]);
+    nodes_seed += node_seed;
+  }
+  hashCombine(seed, nodes_seed);
+  hashCombine(seed, edges_seed);
+
+  graph.cached_hash_ = seed;
+  graph.cached_hash_valid_ = true;
+  return seed;
+}
+
 Rule createRuleFromGraph(const Graph &graph) {
   Rule rule;
   rule.name_ = graph.name_;
@@ -120,8 +169,27 @@ Rule createRuleFromGraph(const Graph &graph) {
   return rule;
 }
 
+GraphIndex::GraphIndex(const Graph &graph)
+    : out_edges_(graph.nodes_.size()), in_edges_(graph.nodes_.size()) {
+  for (EdgeIndex m = 0; m < graph.edges_.size(); ++m) {
+    const Edge &edge = graph.edges_[m];
+    out_edges_[edge.tail_].push_back(m);
+    in_edges_[edge.head_].push_back(m);
+  }
+  for (NodeIndex i = 0; i < graph.nodes_.size(); ++i) {
+    nodes_by_label_[graph.nodes_[i].attrs_.label_].push_back(i);
+  }
+}
+
 std::vector<GraphMapping> findMatches(const Graph &pattern,
                                       const Graph &target) {
+  return findMatches(pattern, target, GraphIndex(target));
+}
+
+std::vector<GraphMapping> findMatches(const Graph &pattern,
+                                      const Graph &target,
+                                      const GraphIndex &target_index) {
+  RD_PERF_SCOPE(PerfPhase::GRAPH_FIND_MATCHES);
   assert(pattern.nodes_.size() >= 1);
 
   // Stack for backtracking, initialized with the first partial match to try
@@ -146,6 +214,28 @@ std::vector<GraphMapping> findMatches(const Graph &pattern,
       continue;
     }
 
+    // If pattern node i has a required label, jump straight to the next
+    // target node with that label using the index's label buckets
+    const std::string &pattern_node_label =
+        pattern.nodes_[i].attrs_.require_label_;
+    if (!pattern_node_label.empty()) {
+      auto bucket_it = target_index.nodes_by_label_.find(pattern_node_label);
+      if (bucket_it == target_index.nodes_by_label_.end()) {
+        j = target.nodes_.size();
+        continue;
+      }
+      const std::vector<NodeIndex> &bucket = bucket_it->second;
+      auto it = std::lower_bound(bucket.begin(), bucket.end(), j);
+      if (it == bucket.end()) {
+        j = target.nodes_.size();
+        continue;
+      }
+      if (*it != j) {
+        j = *it;
+        continue;
+      }
+    }
+
     // No two pattern nodes can map to the same target node (injective mapping)
     if (std::find(pm.node_mapping_.begin(), std::prev(pm.node_mapping_.end()),
                   j) != std::prev(pm.node_mapping_.end())) {
@@ -153,32 +243,24 @@ std::vector<GraphMapping> findMatches(const Graph &pattern,
       continue;
     }
 
-    // If pattern node i has a required label, target node j must have a label
-    // with the same value
-    const std::string &pattern_node_label =
-        pattern.nodes_[i].attrs_.require_label_;
-    const std::string &target_node_label = target.nodes_[j].attrs_.label_;
-    if (!pattern_node_label.empty() &&
-        pattern_node_label != target_node_label) {
-      ++j;
-      continue;
-    }
-
-    // Edges in pattern incident on i must also be present in target
+    // Edges in pattern incident on i must also be present in target, only
+    // the edges incident on j need to be checked
     bool edge_fail = false;
     for (const Edge &pattern_edge : pattern.edges_) {
       const std::string &pattern_label = pattern_edge.attrs_.require_label_;
       if (pattern_edge.head_ == i && pattern_edge.tail_ <= i) {
         // Pattern edge i_tail -> i requires target edge j_tail -> j
         NodeIndex j_tail = pm.node_mapping_[pattern_edge.tail_];
+        const std::vector<EdgeIndex> &candidates = target_index.in_edges_[j];
         auto it = std::find_if(
-            target.edges_.begin(), target.edges_.end(),
-            [&, j, j_tail](const Edge &target_edge) {
+            candidates.begin(), candidates.end(),
+            [&, j_tail](EdgeIndex n) {
+              const Edge &target_edge = target.edges_[n];
               const std::string &target_label = target_edge.attrs_.label_;
-              return target_edge.head_ == j && target_edge.tail_ == j_tail &&
+              return target_edge.tail_ == j_tail &&
                      (pattern_label.empty() || pattern_label == target_label);
             });
-        if (it == target.edges_.end()) {
+        if (it == candidates.end()) {
           // No such target edge exists
           edge_fail = true;
           break;
@@ -186,14 +268,16 @@ std::vector<GraphMapping> findMatches(const Graph &pattern,
       } else if (pattern_edge.tail_ == i && pattern_edge.head_ <= i) {
         // Pattern edge i -> i_head requires target edge j -> j_head
         NodeIndex j_head = pm.node_mapping_[pattern_edge.head_];
+        const std::vector<EdgeIndex> &candidates = target_index.out_edges_[j];
         auto it = std::find_if(
-            target.edges_.begin(), target.edges_.end(),
-            [&, j, j_head](const Edge &target_edge) {
+            candidates.begin(), candidates.end(),
+            [&, j_head](EdgeIndex n) {
+              const Edge &target_edge = target.edges_[n];
               const std::string &target_label = target_edge.attrs_.label_;
-              return target_edge.tail_ == j && target_edge.head_ == j_head &&
+              return target_edge.head_ == j_head &&
                      (pattern_label.empty() || pattern_label == target_label);
             });
-        if (it == target.edges_.end()) {
+        if (it == candidates.end()) {
           // No such target edge exists
           edge_fail = true;
           break;
@@ -217,10 +301,10 @@ std::vector<GraphMapping> findMatches(const Graph &pattern,
         const std::string &pattern_label = pattern_edge.attrs_.require_label_;
         NodeIndex j_head = new_match.node_mapping_[pattern_edge.head_];
         NodeIndex j_tail = new_match.node_mapping_[pattern_edge.tail_];
-        for (EdgeIndex n = 0; n < target.edges_.size(); ++n) {
+        for (EdgeIndex n : target_index.out_edges_[j_tail]) {
           const Edge &target_edge = target.edges_[n];
           const std::string &target_label = target_edge.attrs_.label_;
-          if (target_edge.head_ == j_head && target_edge.tail_ == j_tail &&
+          if (target_edge.head_ == j_head &&
               (pattern_label.empty() || pattern_label == target_label)) {
             new_match.edge_mapping_[m].push_back(n);
           }
@@ -273,6 +357,23 @@ bool checkRuleApplicability(const Rule &rule, const Graph &target,
 Graph applyRule(const Rule &rule, const Graph &target,
                 const GraphMapping &lhs_to_target) {
   Graph result;
+  applyRuleInto(rule, target, lhs_to_target, result);
+  return result;
+}
+
+void applyRuleInto(const Rule &rule, const Graph &target,
+                   const GraphMapping &lhs_to_target, Graph &result) {
+  RD_PERF_SCOPE(PerfPhase::GRAPH_APPLY_RULE);
+  // Reuse the result's storage, and reserve the exact node count and an
+  // upper bound on the edge count up front
+  result.name_.clear();
+  result.nodes_.clear();
+  result.edges_.clear();
+  result.subgraphs_.clear();
+  invalidateGraphHash(result);
+  result.nodes_.reserve(target.nodes_.size() - rule.lhs_.nodes_.size() +
+                        rule.rhs_.nodes_.size());
+  result.edges_.reserve(target.edges_.size() + rule.rhs_.edges_.size());
 
   // Mappings from target and RHS node indices to result node indices
   std::vector<NodeIndex> target_to_result_node(target.nodes_.size(), -1);
@@ -368,8 +469,73 @@ Graph applyRule(const Rule &rule, const Graph &target,
       edge.tail_ = rhs_to_result_node[edge.tail_];
     }
   }
+}
 
-  return result;
+std::vector<Graph> expandGraph(const Graph &graph,
+                               const std::vector<Rule> &rules,
+                               int thread_count) {
+  if (thread_count <= 0) {
+    thread_count = std::thread::hardware_concurrency();
+  }
+  GraphIndex graph_index(graph);
+  ThreadPool thread_pool(thread_count);
+
+  // Find matches for every rule in parallel, sharing the adjacency index
+  std::vector<std::vector<GraphMapping>> rule_matches(rules.size());
+  {
+    std::vector<std::future<void>> futures;
+    futures.reserve(rules.size());
+    for (std::size_t r = 0; r < rules.size(); ++r) {
+      futures.emplace_back(thread_pool.enqueue([&, r] {
+        rule_matches[r] = findMatches(rules[r].lhs_, graph, graph_index);
+      }));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+  }
+
+  // Flatten into (rule, match) pairs so the applications balance evenly
+  std::vector<std::pair<std::size_t, std::size_t>> applications;
+  for (std::size_t r = 0; r < rules.size(); ++r) {
+    for (std::size_t m = 0; m < rule_matches[r].size(); ++m) {
+      applications.emplace_back(r, m);
+    }
+  }
+
+  // Check applicability and apply every pair in parallel; workers also
+  // compute each child's hash digest so deduplication below is a lookup
+  std::vector<Graph> children(applications.size());
+  std::vector<char> valid(applications.size(), 0);
+  {
+    std::vector<std::future<void>> futures;
+    futures.reserve(applications.size());
+    for (std::size_t a = 0; a < applications.size(); ++a) {
+      futures.emplace_back(thread_pool.enqueue([&, a] {
+        const Rule &rule = rules[applications[a].first];
+        const GraphMapping &lhs_to_target =
+            rule_matches[applications[a].first][applications[a].second];
+        if (checkRuleApplicability(rule, graph, lhs_to_target)) {
+          applyRuleInto(rule, graph, lhs_to_target, children[a]);
+          hashGraph(children[a]);
+          valid[a] = 1;
+        }
+      }));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+  }
+
+  // Deduplicate by hash digest, keeping the first occurrence in rule order
+  std::unordered_set<std::size_t> seen_hashes;
+  std::vector<Graph> successors;
+  for (std::size_t a = 0; a < applications.size(); ++a) {
+    if (valid[a] && seen_hashes.insert(hashGraph(children[a])).second) {
+      successors.push_back(std::move(children[a]));
+    }
+  }
+  return successors;
 }
 
 void copyNondefaultAttributes(NodeAttributes &dest, const NodeAttributes &src) {
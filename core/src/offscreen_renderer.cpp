@@ -0,0 +1,209 @@
+#include <cstdlib>
+#include <cstring>
+#include <lodepng.h>
+#include <robot_design/offscreen_renderer.h>
+#include <stdexcept>
+
+namespace robot_design {
+
+OffscreenRenderer::OffscreenRenderer(int width, int height, int pbo_count)
+    : width_(width), height_(height), pbo_count_(pbo_count) {
+  if (!glfwInit()) {
+    throw std::runtime_error("Could not initialize GLFW");
+  }
+
+  // Require OpenGL 3.2 or higher
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+  // The window only provides a GL context, rendering happens in an FBO
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  window_ = glfwCreateWindow(1, 1, "Robot Design Offscreen Renderer", NULL,
+                             NULL);
+  if (!window_) {
+    throw std::runtime_error("Could not create GLFW window");
+  }
+
+  glfwMakeContextCurrent(window_);
+
+  // Load all available extensions even if they are not in the extensions string
+  glewExperimental = GL_TRUE;
+  glewInit();
+
+  // Create renderer (holder for OpenGL resources)
+  const char *data_dir = std::getenv("ROBOT_DESIGN_DATA_DIR");
+  if (!data_dir) {
+    // Data directory was not provided, use the default
+    data_dir = "data/";
+  }
+  renderer_ = std::make_shared<GLRenderer>(data_dir);
+
+  createFramebuffer();
+  createPixelBuffers();
+
+  worker_ = std::thread(&OffscreenRenderer::workerLoop, this);
+}
+
+OffscreenRenderer::~OffscreenRenderer() {
+  finish();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  worker_.join();
+
+  glDeleteBuffers(pixel_buffers_.size(), pixel_buffers_.data());
+  framebuffer_.reset();
+  color_texture_.reset();
+  depth_texture_.reset();
+  renderer_.reset();
+  glfwDestroyWindow(window_);
+  glfwTerminate();
+}
+
+void OffscreenRenderer::createFramebuffer() {
+  color_texture_ = std::make_shared<Texture2D>(
+      /*target=*/GL_TEXTURE_2D, /*level=*/0, /*internal_format=*/GL_RGBA,
+      /*width=*/width_, /*height=*/height_, /*format=*/GL_RGBA,
+      /*type=*/GL_UNSIGNED_BYTE);
+  depth_texture_ = std::make_shared<Texture2D>(
+      /*target=*/GL_TEXTURE_2D, /*level=*/0,
+      /*internal_format=*/GL_DEPTH_COMPONENT,
+      /*width=*/width_, /*height=*/height_, /*format=*/GL_DEPTH_COMPONENT,
+      /*type=*/GL_FLOAT);
+  framebuffer_ = std::make_shared<Framebuffer>();
+  framebuffer_->attachColorTexture(*color_texture_);
+  framebuffer_->attachDepthTexture(*depth_texture_);
+}
+
+void OffscreenRenderer::createPixelBuffers() {
+  pixel_buffers_.resize(pbo_count_);
+  pending_frame_idx_.assign(pbo_count_, -1);
+  glGenBuffers(pixel_buffers_.size(), pixel_buffers_.data());
+  for (GLuint pixel_buffer : pixel_buffers_) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 4 * width_ * height_, NULL,
+                 GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void OffscreenRenderer::render(const Simulation &sim, unsigned char *pixels) {
+  camera_params_.aspect_ratio_ = static_cast<float>(width_) / height_;
+  renderer_->render(sim, camera_params_, render_params_, width_, height_,
+                    framebuffer_.get());
+
+  if (pixels) {
+    framebuffer_->bind();
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return;
+  }
+  if (!frame_callback_) {
+    return;
+  }
+
+  // Readback is two phases of the PBO ring apart; the copy into the slot's
+  // PBO started pbo_count_ frames ago and has had time to complete, so
+  // mapping it here should not stall
+  int slot = frame_count_ % pbo_count_;
+  if (pending_frame_idx_[slot] >= 0) {
+    completeReadback(slot);
+  }
+  framebuffer_->bind();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[slot]);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  pending_frame_idx_[slot] = frame_count_;
+  ++frame_count_;
+}
+
+void OffscreenRenderer::completeReadback(int slot) {
+  QueuedFrame frame;
+  frame.frame_idx_ = pending_frame_idx_[slot];
+  frame.pixels_.resize(4 * width_ * height_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[slot]);
+  const void *mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (!mapped) {
+    throw std::runtime_error("Could not map pixel buffer object");
+  }
+  std::memcpy(frame.pixels_.data(), mapped, frame.pixels_.size());
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  pending_frame_idx_[slot] = -1;
+
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  // Block instead of queueing frames faster than the worker consumes them
+  queue_cv_.wait(lock,
+                 [&] { return frame_queue_.size() < max_queue_size_; });
+  frame_queue_.push_back(std::move(frame));
+  queue_cv_.notify_all();
+}
+
+void OffscreenRenderer::workerLoop() {
+  while (true) {
+    QueuedFrame frame;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [&] { return !frame_queue_.empty() || shutdown_; });
+      if (frame_queue_.empty()) {
+        return;
+      }
+      frame = std::move(frame_queue_.front());
+      frame_queue_.pop_front();
+      queue_cv_.notify_all();
+    }
+    frame_callback_(frame.frame_idx_, width_, height_, frame.pixels_.data());
+  }
+}
+
+void OffscreenRenderer::finish() {
+  // Complete in-flight readbacks in submission order
+  for (int i = 0; i < pbo_count_; ++i) {
+    int slot = (frame_count_ + i) % pbo_count_;
+    if (pending_frame_idx_[slot] >= 0) {
+      completeReadback(slot);
+    }
+  }
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  queue_cv_.wait(lock, [&] { return frame_queue_.empty(); });
+}
+
+void OffscreenRenderer::getFramebufferSize(int &width, int &height) const {
+  width = width_;
+  height = height_;
+}
+
+void OffscreenRenderer::setFramebufferSize(int width, int height) {
+  finish();
+  width_ = width;
+  height_ = height;
+  glDeleteBuffers(pixel_buffers_.size(), pixel_buffers_.data());
+  createFramebuffer();
+  createPixelBuffers();
+}
+
+void OffscreenRenderer::setFrameCallback(const FrameCallback &frame_callback) {
+  finish();
+  frame_callback_ = frame_callback;
+}
+
+void OffscreenRenderer::writeFramePNG(const std::string &path, int width,
+                                      int height,
+                                      const unsigned char *pixels) {
+  // glReadPixels returns rows bottom-up, PNG stores them top-down
+  std::vector<unsigned char> flipped(4 * width * height);
+  for (int y = 0; y < height; ++y) {
+    std::memcpy(&flipped[4 * width * y], &pixels[4 * width * (height - 1 - y)],
+                4 * width);
+  }
+  unsigned int error =
+      lodepng_encode32_file(path.c_str(), flipped.data(), width, height);
+  if (error) {
+    throw std::runtime_error("Could not write frame to file \"" + path +
+                             "\": " + lodepng_error_text(error));
+  }
+}
+
+} // namespace robot_design
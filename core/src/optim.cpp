@@ -1,8 +1,60 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <random>
+#include <robot_design/distributed.h>
 #include <robot_design/optim.h>
+#include <robot_design/perf.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace robot_design {
 
+// Number of horizon checkpoints at which pruned rollouts compare their
+// partial return against the running best
+constexpr int PRUNING_CHECKPOINT_COUNT = 8;
+
+namespace {
+
+// SplitMix64; each output depends only on (key + counter), so noise values
+// can be generated independently in any order with no sequential state
+inline std::uint64_t splitMix64(std::uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// Fills out with standard normal values derived from key via the Box-Muller
+// transform, with the transcendental math applied to whole arrays
+void fillStandardNormal(std::uint64_t key, MatrixX &out) {
+  constexpr Scalar two_pow_53 = 9007199254740992.0;
+  Eigen::Index count = out.size();
+  Eigen::Index pair_count = (count + 1) / 2;
+  Eigen::ArrayXd radius(pair_count), angle(pair_count);
+  for (Eigen::Index i = 0; i < pair_count; ++i) {
+    // The high 53 bits are uniform; adding 1 keeps the value in (0, 1]
+    radius(i) = ((splitMix64(key + 2 * i) >> 11) + 1) / two_pow_53;
+    angle(i) = (splitMix64(key + 2 * i + 1) >> 11) *
+               (2.0 * M_PI / two_pow_53);
+  }
+  radius = (-2.0 * radius.log()).sqrt();
+  Eigen::ArrayXd n0 = radius * angle.cos();
+  Eigen::ArrayXd n1 = radius * angle.sin();
+  Scalar *data = out.data();
+  for (Eigen::Index i = 0; i < pair_count; ++i) {
+    data[2 * i] = n0(i);
+    if (2 * i + 1 < count) {
+      data[2 * i + 1] = n1(i);
+    }
+  }
+}
+
+} // namespace
+
 DefaultInputSampler::DefaultInputSampler(Scalar history_std_dev,
                                          Scalar warm_start_std_dev)
     : history_std_dev_(history_std_dev),
@@ -49,6 +101,58 @@ void DefaultInputSampler::sampleInputSequence(
   }
 }
 
+VectorizedInputSampler::VectorizedInputSampler(Scalar history_std_dev,
+                                               Scalar warm_start_std_dev)
+    : history_std_dev_(history_std_dev),
+      warm_start_std_dev_(warm_start_std_dev) {}
+
+void VectorizedInputSampler::sampleInputSequence(
+    Ref<MatrixX> input_seq, unsigned int sample_seed, int sample_idx,
+    const Ref<const MatrixX> &last_input_seq,
+    const Ref<const MatrixX> &history) const {
+  int dof_count = last_input_seq.rows();
+  int horizon = last_input_seq.cols();
+  int history_len = history.cols();
+
+  Scalar std_dev;
+  // Half of the samples are based on repeating past motion ("history")
+  if (history_len >= horizon && sample_idx % 2 == 0) {
+    // The repetition period should range from (horizon / 2 + 1) to horizon
+    int repeat_len = (sample_idx / 2) % (horizon / 2) + horizon / 2 + 1;
+    for (int j = 0; j < horizon; ++j) {
+      // Linearly interpolate to avoid sudden changes in the inputs
+      Scalar t = static_cast<Scalar>(j + 1) / horizon;
+      input_seq.col(j) =
+          t * history.rightCols(repeat_len).replicate(1, horizon).col(j) +
+          (1.0 - t) * last_input_seq.col(j);
+    }
+    std_dev = history_std_dev_;
+  } else {
+    input_seq = last_input_seq;
+    std_dev = warm_start_std_dev_;
+  }
+
+  Eigen::Vector<Scalar, 5> filter_coeffs;
+  // FIR filter with passband below 2 Hz, stopband above 4 Hz at f_s = 15 Hz
+  filter_coeffs << 0.10422766377112629, 0.3239870556899027, 0.3658903830367387,
+      0.3239870556899027, 0.10422766377112629;
+  int filter_len = filter_coeffs.size();
+
+  // Each (sample_seed, sample_idx) pair selects a disjoint counter range
+  std::uint64_t key =
+      splitMix64((static_cast<std::uint64_t>(sample_seed) << 32) ^
+                 static_cast<std::uint64_t>(sample_idx));
+  MatrixX noise(dof_count, horizon + filter_len - 1);
+  fillStandardNormal(key, noise);
+
+  // Apply the filter as one banded matrix product instead of per column
+  MatrixX filter = MatrixX::Zero(horizon + filter_len - 1, horizon);
+  for (int j = 0; j < horizon; ++j) {
+    filter.col(j).segment(j, filter_len) = filter_coeffs;
+  }
+  input_seq.noalias() += std_dev * (noise * filter);
+}
+
 void ConstantInputSampler::sampleInputSequence(
     Ref<MatrixX> input_seq, unsigned int sample_seed, int sample_idx,
     const Ref<const MatrixX> &last_input_seq,
@@ -57,6 +161,86 @@ void ConstantInputSampler::sampleInputSequence(
                              input_seq.cols());
 }
 
+RolloutExecutor::RolloutExecutor(int thread_count) {
+  workers_.reserve(thread_count);
+  for (int i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(&RolloutExecutor::workerLoop, this);
+#if defined(__linux__)
+    // Pin each worker to one core to avoid migration in the hot loop
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(i % std::thread::hardware_concurrency(), &cpu_set);
+    pthread_setaffinity_np(workers_.back().native_handle(), sizeof(cpu_set),
+                           &cpu_set);
+#endif
+  }
+}
+
+RolloutExecutor::~RolloutExecutor() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void RolloutExecutor::run(int count,
+                          const std::function<void(int)> &task_fn) {
+  if (count <= 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_fn_ = &task_fn;
+  task_count_ = count;
+  next_idx_.store(0, std::memory_order_relaxed);
+  remaining_.store(count, std::memory_order_relaxed);
+  ++generation_;
+  lock.unlock();
+  start_cv_.notify_all();
+
+  lock.lock();
+  done_cv_.wait(lock, [&] {
+    return remaining_.load(std::memory_order_acquire) == 0;
+  });
+  task_fn_ = nullptr;
+}
+
+void RolloutExecutor::workerLoop() {
+  std::uint64_t last_generation = 0;
+  while (true) {
+    const std::function<void(int)> *task_fn;
+    int task_count;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [&] {
+        return shutdown_ || generation_ != last_generation;
+      });
+      if (shutdown_) {
+        return;
+      }
+      last_generation = generation_;
+      task_fn = task_fn_;
+      task_count = task_count_;
+    }
+    while (true) {
+      int idx = next_idx_.fetch_add(1, std::memory_order_relaxed);
+      if (idx >= task_count) {
+        break;
+      }
+      (*task_fn)(idx);
+      if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Last index finished, wake the caller
+        std::unique_lock<std::mutex> lock(mutex_);
+        lock.unlock();
+        done_cv_.notify_one();
+      }
+    }
+  }
+}
+
 MPPIOptimizer::MPPIOptimizer(
     Scalar kappa, Scalar discount_factor, int dof_count, int interval,
     int horizon, int sample_count, int thread_count, unsigned int seed,
@@ -67,7 +251,7 @@ MPPIOptimizer::MPPIOptimizer(
       interval_(interval), horizon_(horizon), sample_count_(sample_count),
       seed_(seed), objective_fn_(objective_fn),
       value_estimator_(value_estimator), input_sampler_(input_sampler),
-      thread_pool_(thread_count) {
+      rollout_executor_(thread_count) {
   // Create a separate simulation instance for each sample
   sim_instances_.reserve(sample_count);
   for (int i = 0; i < sample_count; ++i) {
@@ -75,60 +259,203 @@ MPPIOptimizer::MPPIOptimizer(
   }
 
   input_sequence_ = MatrixX::Zero(dof_count, horizon);
+  sample_input_seqs_.resize(dof_count * horizon, sample_count);
   final_obs_.resize(value_estimator->getObservationSize(), sample_count);
   history_ = MatrixX::Zero(dof_count, horizon);
   total_step_count_ = 0;
+
+  // Detect statically known objective types up front; runSimulation then
+  // dispatches to a rollout with the reward computation inlined
+  sos_objective_ = objective_fn_.target<SumOfSquaresObjective>();
+  dot_objective_ = objective_fn_.target<DotProductObjective>();
+  objective_state_buffers_.resize(sample_count);
 }
 
-void MPPIOptimizer::update() {
-  // Sample trajectories with different seeds
-  std::vector<std::future<double>> sim_results;
-  sim_results.reserve(sample_count_);
-  for (int k = 0; k < sample_count_; ++k) {
-    sim_results.emplace_back(
-        thread_pool_.enqueue(&MPPIOptimizer::runSimulation, this, seed_, k));
+void MPPIOptimizer::setRolloutPruning(bool enabled, Scalar margin) {
+  rollout_pruning_ = enabled;
+  pruning_margin_ = margin;
+  if (enabled && checkpoint_best_.empty()) {
+    checkpoint_best_ =
+        std::vector<std::atomic<Scalar>>(PRUNING_CHECKPOINT_COUNT);
   }
+}
 
-  // Wait on results
-  VectorX sim_returns(sample_count_);
-  for (int k = 0; k < sample_count_; ++k) {
-    sim_returns(k) = sim_results[k].get();
+void MPPIOptimizer::setPipelinedValueEstimation(bool enabled,
+                                                int chunk_count) {
+  if (chunk_count < 1) {
+    throw std::invalid_argument("Chunk count must be at least 1");
   }
+  pipelined_value_est_ = enabled;
+  value_est_chunk_count_ = chunk_count;
+}
+
+void MPPIOptimizer::addRemoteWorker(const std::string &host, int port,
+                                    int sample_share) {
+  remote_workers_.push_back(
+      std::make_shared<RemoteRolloutClient>(host, port, sample_share));
+}
 
-  // Estimate (discounted) values of final states and add to simulation return
+void MPPIOptimizer::update() {
+  if (rollout_pruning_) {
+    for (auto &best : checkpoint_best_) {
+      best.store(-std::numeric_limits<Scalar>::infinity(),
+                 std::memory_order_relaxed);
+    }
+  }
+
+  // Sample trajectories with different seeds across the persistent workers,
+  // and estimate (discounted) values of final states
+  VectorX sim_returns(sample_count_);
   VectorX final_value_est(sample_count_);
-  value_estimator_->estimateValue(final_obs_, final_value_est);
+  if (!remote_workers_.empty()) {
+    // Broadcast the compact snapshot, seed range, and current sequences to
+    // the remote workers, then run the local share while they simulate.
+    // Rollouts are reproducible from (seed, sample index), so per sample
+    // only the return and final observation cross the wire
+    auto *sync_sim = dynamic_cast<BulletSimulation *>(sim_instances_[0].get());
+    if (sync_sim == nullptr) {
+      throw std::invalid_argument(
+          "Distributed sampling requires BulletSimulation instances");
+    }
+    VectorX packed_state(sync_sim->getPackedStateSize());
+    sync_sim->getPackedState(packed_state);
+    // Assign worker shares from the tail of the sample range
+    std::vector<std::pair<int, int>> remote_ranges(remote_workers_.size());
+    int next_start = sample_count_;
+    for (std::size_t w = remote_workers_.size(); w-- > 0;) {
+      int count = std::min(remote_workers_[w]->getSampleShare(), next_start);
+      next_start -= count;
+      remote_ranges[w] = {next_start, count};
+      if (count > 0) {
+        remote_workers_[w]->requestRollouts(seed_, next_start, count,
+                                            packed_state, input_sequence_,
+                                            history_);
+      }
+    }
+    int local_count = next_start;
+    // Collector threads block on the network while the local rollouts run
+    std::vector<std::exception_ptr> collect_errors(remote_workers_.size());
+    std::vector<std::thread> collectors;
+    for (std::size_t w = 0; w < remote_workers_.size(); ++w) {
+      int start = remote_ranges[w].first;
+      int count = remote_ranges[w].second;
+      if (count == 0) {
+        continue;
+      }
+      collectors.emplace_back([&, w, start, count]() {
+        try {
+          remote_workers_[w]->collectResults(
+              sim_returns.segment(start, count),
+              final_obs_.middleCols(start, count));
+        } catch (...) {
+          collect_errors[w] = std::current_exception();
+        }
+      });
+    }
+    rollout_executor_.run(local_count, [&](int k) {
+      sim_returns(k) = runSimulation(seed_, k);
+    });
+    // Regenerate the remote samples' input sequences (deterministic in
+    // (seed, sample index)) so the weighting step sees every sequence
+    for (int k = local_count; k < sample_count_; ++k) {
+      Eigen::Map<MatrixX> rand_input_seq(sample_input_seqs_.col(k).data(),
+                                         dof_count_, horizon_);
+      input_sampler_->sampleInputSequence(rand_input_seq, seed_, k,
+                                          input_sequence_, history_);
+    }
+    for (std::thread &collector : collectors) {
+      collector.join();
+    }
+    for (std::exception_ptr &error : collect_errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+    {
+      RD_PERF_SCOPE(PerfPhase::MPPI_VALUE_ESTIMATION);
+      value_estimator_->estimateValue(final_obs_, final_value_est);
+    }
+  } else if (pipelined_value_est_ &&
+             value_estimator_->getObservationSize() > 0) {
+    int chunk_count = std::min(value_est_chunk_count_, sample_count_);
+    int chunk_size = (sample_count_ + chunk_count - 1) / chunk_count;
+    chunk_count = (sample_count_ + chunk_size - 1) / chunk_size;
+    std::vector<std::atomic<int>> chunk_remaining(chunk_count);
+    for (int c = 0; c < chunk_count; ++c) {
+      chunk_remaining[c].store(
+          std::min(chunk_size, sample_count_ - c * chunk_size),
+          std::memory_order_relaxed);
+    }
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::vector<int> ready_chunks;
+    // The estimator runs on its own thread, consuming chunks of completed
+    // rollouts while the remaining rollouts still run. Chunks are copied out
+    // of final_obs_ so the estimator never touches columns the workers are
+    // still filling in
+    std::thread estimator_thread([&]() {
+      MatrixX chunk_obs;
+      for (int processed = 0; processed < chunk_count; ++processed) {
+        int c;
+        {
+          std::unique_lock<std::mutex> lock(queue_mutex);
+          queue_cv.wait(lock, [&]() { return !ready_chunks.empty(); });
+          c = ready_chunks.back();
+          ready_chunks.pop_back();
+        }
+        int start = c * chunk_size;
+        int len = std::min(chunk_size, sample_count_ - start);
+        chunk_obs = final_obs_.middleCols(start, len);
+        RD_PERF_SCOPE(PerfPhase::MPPI_VALUE_ESTIMATION);
+        value_estimator_->estimateValue(chunk_obs,
+                                        final_value_est.segment(start, len));
+      }
+    });
+    rollout_executor_.run(sample_count_, [&](int k) {
+      sim_returns(k) = runSimulation(seed_, k);
+      // The last rollout of a chunk hands it to the estimator
+      int c = k / chunk_size;
+      if (chunk_remaining[c].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        {
+          std::lock_guard<std::mutex> lock(queue_mutex);
+          ready_chunks.push_back(c);
+        }
+        queue_cv.notify_one();
+      }
+    });
+    estimator_thread.join();
+  } else {
+    rollout_executor_.run(sample_count_, [&](int k) {
+      sim_returns(k) = runSimulation(seed_, k);
+    });
+    {
+      RD_PERF_SCOPE(PerfPhase::MPPI_VALUE_ESTIMATION);
+      value_estimator_->estimateValue(final_obs_, final_value_est);
+    }
+  }
   sim_returns += final_value_est * std::pow(discount_factor_, horizon_);
 
-  MatrixX input_sequence_sum = MatrixX::Zero(dof_count_, horizon_);
-  Scalar seq_weight_sum = 0.0;
-  MatrixX rand_input_seq(dof_count_, horizon_);
-  Scalar max_return = sim_returns.maxCoeff();
-  for (int k = 0; k < sample_count_; ++k) {
-    // Recreate the same input sequence used for the simulation
-    input_sampler_->sampleInputSequence(rand_input_seq, seed_, k,
-                                        input_sequence_, history_);
-    Scalar seq_weight = std::exp(kappa_ * (sim_returns(k) - max_return));
-    input_sequence_sum += rand_input_seq * seq_weight;
-    seq_weight_sum += seq_weight;
+  // Weight the input sequences cached by the workers, as one matrix-vector
+  // product over the flattened sequences
+  {
+    RD_PERF_SCOPE(PerfPhase::MPPI_WEIGHTING);
+    Scalar max_return = sim_returns.maxCoeff();
+    VectorX seq_weights =
+        (kappa_ * (sim_returns.array() - max_return)).exp().matrix();
+    VectorX input_sequence_sum =
+        sample_input_seqs_ * (seq_weights / seq_weights.sum());
+    input_sequence_ = Eigen::Map<MatrixX>(input_sequence_sum.data(),
+                                          dof_count_, horizon_);
   }
-  input_sequence_ = input_sequence_sum / seq_weight_sum;
 
   seed_ += sample_count_;
 }
 
 void MPPIOptimizer::advance(int step_count) {
-  std::vector<std::future<void>> futures;
-  futures.reserve(sample_count_);
-  for (int k = 0; k < sample_count_; ++k) {
-    futures.emplace_back(thread_pool_.enqueue(&MPPIOptimizer::advanceSimulation,
-                                              this, k, step_count));
-  }
-
-  // Wait for all simulation instances to advance
-  for (int k = 0; k < sample_count_; ++k) {
-    futures[k].get();
-  }
+  // Advance all simulation instances across the persistent workers
+  rollout_executor_.run(sample_count_, [&](int k) {
+    advanceSimulation(k, step_count);
+  });
   // Shift the contents of history_ to the left by step_count
   for (int j = 0; j < history_.cols() - step_count; ++j) {
     history_.col(j) = history_.col(j + step_count);
@@ -151,7 +478,9 @@ void MPPIOptimizer::setSampleCount(int sample_count) {
   if (sample_count <= sample_count_) {
     sample_count_ = sample_count;
     sim_instances_.resize(sample_count);
+    sample_input_seqs_.resize(dof_count_ * horizon_, sample_count);
     final_obs_.resize(value_estimator_->getObservationSize(), sample_count);
+    objective_state_buffers_.resize(sample_count);
   } else {
     // Increasing the sample count is not supported yet
     throw std::invalid_argument("Cannot increase sample count");
@@ -159,21 +488,78 @@ void MPPIOptimizer::setSampleCount(int sample_count) {
 }
 
 Scalar MPPIOptimizer::runSimulation(unsigned int sample_seed, int sample_idx) {
+  // Specialized objectives are evaluated through a lambda the compiler can
+  // inline into the rollout loop, reusing this sample's preallocated state
+  // buffer; Python-defined objectives take the generic std::function path
+  if (sos_objective_ != nullptr) {
+    const SumOfSquaresObjective &objective = *sos_objective_;
+    VectorX &state = objective_state_buffers_[sample_idx];
+    return runSimulationImpl(
+        sample_seed, sample_idx,
+        [&](const Simulation &sim) { return objective(sim, state); });
+  }
+  if (dot_objective_ != nullptr) {
+    const DotProductObjective &objective = *dot_objective_;
+    VectorX &state = objective_state_buffers_[sample_idx];
+    return runSimulationImpl(
+        sample_seed, sample_idx,
+        [&](const Simulation &sim) { return objective(sim, state); });
+  }
+  return runSimulationImpl(sample_seed, sample_idx, objective_fn_);
+}
+
+template <typename EvalFn>
+Scalar MPPIOptimizer::runSimulationImpl(unsigned int sample_seed,
+                                        int sample_idx,
+                                        const EvalFn &eval_fn) {
   Simulation &sim = *sim_instances_[sample_idx];
   Index robot_idx = 0; // TODO: don't assume there is only one robot
-  MatrixX rand_input_seq(dof_count_, horizon_);
-  input_sampler_->sampleInputSequence(rand_input_seq, sample_seed, sample_idx,
-                                      input_sequence_, history_);
+  // Sample directly into this sample's preallocated column, update() will
+  // reuse the sequence for weighting
+  Eigen::Map<MatrixX> rand_input_seq(sample_input_seqs_.col(sample_idx).data(),
+                                     dof_count_, horizon_);
+  {
+    RD_PERF_SCOPE(PerfPhase::MPPI_SAMPLING);
+    input_sampler_->sampleInputSequence(rand_input_seq, sample_seed,
+                                        sample_idx, input_sequence_, history_);
+  }
   sim.saveState();
   Scalar sim_return = 0.0;
   Scalar discount_prod = 1.0;
+  int checkpoint_interval =
+      rollout_pruning_ ? std::max(1, horizon_ / PRUNING_CHECKPOINT_COUNT) : 0;
   for (int j = 0; j < horizon_; ++j) {
     for (int i = 0; i < interval_; ++i) {
       sim.setJointTargets(robot_idx, rand_input_seq.col(j));
-      sim.step();
-      sim_return += objective_fn_(sim) * discount_prod;
+      {
+        RD_PERF_SCOPE(PerfPhase::MPPI_STEPPING);
+        sim.step();
+      }
+      {
+        RD_PERF_SCOPE(PerfPhase::MPPI_OBJECTIVE);
+        sim_return += eval_fn(sim) * discount_prod;
+      }
     }
     discount_prod *= discount_factor_;
+
+    if (rollout_pruning_ && (j + 1) % checkpoint_interval == 0 &&
+        j + 1 < horizon_) {
+      int c = std::min((j + 1) / checkpoint_interval - 1,
+                       PRUNING_CHECKPOINT_COUNT - 1);
+      // Publish this rollout's partial return (atomic running max)
+      std::atomic<Scalar> &best = checkpoint_best_[c];
+      Scalar prev_best = best.load(std::memory_order_relaxed);
+      while (prev_best < sim_return &&
+             !best.compare_exchange_weak(prev_best, sim_return,
+                                         std::memory_order_relaxed)) {
+      }
+      // Abort once this rollout is dominated; its weight in update() would
+      // be at most exp(-pruning_margin_)
+      if (sim_return <
+          best.load(std::memory_order_relaxed) - pruning_margin_ / kappa_) {
+        break;
+      }
+    }
   }
   // Collect observation for final state
   value_estimator_->getObservation(sim, final_obs_.col(sample_idx));
@@ -193,17 +579,23 @@ void MPPIOptimizer::advanceSimulation(int sample_idx, int step_count) {
 }
 
 Scalar SumOfSquaresObjective::operator()(const Simulation &sim) const {
+  VectorX state;
+  return (*this)(sim, state);
+}
+
+Scalar SumOfSquaresObjective::operator()(const Simulation &sim,
+                                         VectorX &state) const {
   Scalar cost = 0.0;
   for (Index robot_idx = 0; robot_idx < sim.getRobotCount(); ++robot_idx) {
     int dof_count = sim.getRobotDofCount(robot_idx);
-    Vector6 base_vel;
-    sim.getLinkVelocity(robot_idx, 0, base_vel);
-    VectorX joint_vel(dof_count);
-    sim.getJointVelocities(robot_idx, joint_vel);
-    VectorX motor_torques(dof_count);
-    sim.getJointMotorTorques(robot_idx, motor_torques);
+    state.resize(Simulation::FULL_STATE_BASE_SIZE + 3 * dof_count);
+    sim.getFullState(robot_idx, state);
+    auto joint_vel =
+        state.segment(Simulation::FULL_STATE_BASE_SIZE + dof_count, dof_count);
+    auto motor_torques = state.segment(
+        Simulation::FULL_STATE_BASE_SIZE + 2 * dof_count, dof_count);
     // Velocity error term
-    Vector6 vel_error = base_vel - base_vel_ref_;
+    Vector6 vel_error = state.segment<6>(16) - base_vel_ref_;
     cost += vel_error.transpose() * base_vel_weight_.asDiagonal() * vel_error;
     // Power consumption term
     Scalar power = motor_torques.dot(joint_vel);
@@ -214,25 +606,29 @@ Scalar SumOfSquaresObjective::operator()(const Simulation &sim) const {
 }
 
 Scalar DotProductObjective::operator()(const Simulation &sim) const {
+  VectorX state;
+  return (*this)(sim, state);
+}
+
+Scalar DotProductObjective::operator()(const Simulation &sim,
+                                       VectorX &state) const {
   Scalar reward = 0.0;
   for (Index robot_idx = 0; robot_idx < sim.getRobotCount(); ++robot_idx) {
     int dof_count = sim.getRobotDofCount(robot_idx);
-    Matrix4 base_transform;
-    sim.getLinkTransform(robot_idx, 0, base_transform);
-    Vector6 base_vel;
-    sim.getLinkVelocity(robot_idx, 0, base_vel);
-    VectorX joint_vel(dof_count);
-    sim.getJointVelocities(robot_idx, joint_vel);
-    VectorX motor_torques(dof_count);
-    sim.getJointMotorTorques(robot_idx, motor_torques);
-    // Base direction term
-    Vector3 base_dir = base_transform.block<3, 1>(0, 0);
+    state.resize(Simulation::FULL_STATE_BASE_SIZE + 3 * dof_count);
+    sim.getFullState(robot_idx, state);
+    auto joint_vel =
+        state.segment(Simulation::FULL_STATE_BASE_SIZE + dof_count, dof_count);
+    auto motor_torques = state.segment(
+        Simulation::FULL_STATE_BASE_SIZE + 2 * dof_count, dof_count);
+    // Base direction term (first column of the base transform)
+    Vector3 base_dir = state.segment<3>(0);
     reward += base_dir.dot(base_dir_weight_);
-    // Base up vector term
-    Vector3 base_up = base_transform.block<3, 1>(0, 1);
+    // Base up vector term (second column of the base transform)
+    Vector3 base_up = state.segment<3>(4);
     reward += base_up.dot(base_up_weight_);
-    // Base velocity term
-    reward += base_vel.tail<3>().dot(base_vel_weight_);
+    // Base linear velocity term
+    reward += state.segment<3>(19).dot(base_vel_weight_);
     // Power consumption term
     Scalar power = motor_torques.dot(joint_vel);
     reward += power_weight_ * power;
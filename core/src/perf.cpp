@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <mutex>
+#include <robot_design/perf.h>
+#include <vector>
+
+namespace robot_design {
+
+const char *getPerfPhaseName(PerfPhase phase) {
+  switch (phase) {
+  case PerfPhase::MPPI_SAMPLING:
+    return "mppi_sampling";
+  case PerfPhase::MPPI_STEPPING:
+    return "mppi_stepping";
+  case PerfPhase::MPPI_OBJECTIVE:
+    return "mppi_objective";
+  case PerfPhase::MPPI_VALUE_ESTIMATION:
+    return "mppi_value_estimation";
+  case PerfPhase::MPPI_WEIGHTING:
+    return "mppi_weighting";
+  case PerfPhase::SIM_STEP:
+    return "sim_step";
+  case PerfPhase::GRAPH_FIND_MATCHES:
+    return "graph_find_matches";
+  case PerfPhase::GRAPH_APPLY_RULE:
+    return "graph_apply_rule";
+  }
+  return "unknown";
+}
+
+#if !defined(ROBOT_DESIGN_DISABLE_PROFILING)
+
+namespace perf_internal {
+
+namespace {
+
+struct ThreadState {
+  ThreadState();
+  ~ThreadState();
+  std::array<PhaseAccum, PERF_PHASE_COUNT> phases_;
+};
+
+// Registry of live per-thread accumulators plus totals and samples carried
+// over from exited threads
+struct Registry {
+  std::mutex mutex_;
+  std::vector<ThreadState *> live_states_;
+  std::array<std::uint64_t, PERF_PHASE_COUNT> retired_counts_{};
+  std::array<std::uint64_t, PERF_PHASE_COUNT> retired_total_ns_{};
+  std::array<std::vector<std::uint64_t>, PERF_PHASE_COUNT> retired_samples_;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+// Copies the filled portion of an accumulator's sample ring into out
+void gatherSamples(const PhaseAccum &accum, std::vector<std::uint64_t> &out) {
+  std::uint64_t count = accum.count_.load(std::memory_order_relaxed);
+  std::size_t filled =
+      std::min<std::uint64_t>(count, PERF_SAMPLE_RING_SIZE);
+  for (std::size_t i = 0; i < filled; ++i) {
+    out.push_back(accum.samples_[i].load(std::memory_order_relaxed));
+  }
+}
+
+ThreadState &threadState() {
+  thread_local ThreadState state;
+  return state;
+}
+
+} // namespace
+
+ThreadState::ThreadState() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex_);
+  reg.live_states_.push_back(this);
+}
+
+ThreadState::~ThreadState() {
+  // Fold this thread's statistics into the retired accumulators so they
+  // survive the thread
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex_);
+  for (int p = 0; p < PERF_PHASE_COUNT; ++p) {
+    reg.retired_counts_[p] +=
+        phases_[p].count_.load(std::memory_order_relaxed);
+    reg.retired_total_ns_[p] +=
+        phases_[p].total_ns_.load(std::memory_order_relaxed);
+    gatherSamples(phases_[p], reg.retired_samples_[p]);
+    // Keep only the most recent ring's worth of retired samples per phase
+    std::vector<std::uint64_t> &retired = reg.retired_samples_[p];
+    if (retired.size() > PERF_SAMPLE_RING_SIZE) {
+      retired.erase(retired.begin(),
+                    retired.end() - PERF_SAMPLE_RING_SIZE);
+    }
+  }
+  reg.live_states_.erase(std::remove(reg.live_states_.begin(),
+                                     reg.live_states_.end(), this),
+                         reg.live_states_.end());
+}
+
+void recordSample(PerfPhase phase, std::uint64_t duration_ns) {
+  PhaseAccum &accum = threadState().phases_[static_cast<int>(phase)];
+  std::uint64_t idx = accum.count_.fetch_add(1, std::memory_order_relaxed);
+  accum.total_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+  accum.samples_[idx % PERF_SAMPLE_RING_SIZE].store(
+      duration_ns, std::memory_order_relaxed);
+}
+
+} // namespace perf_internal
+
+std::array<PerfPhaseStats, PERF_PHASE_COUNT> getPerfStats() {
+  using namespace perf_internal;
+  std::array<PerfPhaseStats, PERF_PHASE_COUNT> stats;
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex_);
+  std::vector<std::uint64_t> samples;
+  for (int p = 0; p < PERF_PHASE_COUNT; ++p) {
+    PerfPhaseStats &phase_stats = stats[p];
+    phase_stats.count_ = reg.retired_counts_[p];
+    phase_stats.total_ns_ = reg.retired_total_ns_[p];
+    samples.assign(reg.retired_samples_[p].begin(),
+                   reg.retired_samples_[p].end());
+    for (ThreadState *state : reg.live_states_) {
+      const PhaseAccum &accum = state->phases_[p];
+      phase_stats.count_ += accum.count_.load(std::memory_order_relaxed);
+      phase_stats.total_ns_ +=
+          accum.total_ns_.load(std::memory_order_relaxed);
+      gatherSamples(accum, samples);
+    }
+    if (!samples.empty()) {
+      std::sort(samples.begin(), samples.end());
+      auto quantile = [&](double q) {
+        return samples[static_cast<std::size_t>(q * (samples.size() - 1))];
+      };
+      phase_stats.p50_ns_ = quantile(0.5);
+      phase_stats.p90_ns_ = quantile(0.9);
+      phase_stats.p99_ns_ = quantile(0.99);
+      phase_stats.max_ns_ = samples.back();
+    }
+  }
+  return stats;
+}
+
+void resetPerfStats() {
+  using namespace perf_internal;
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex_);
+  reg.retired_counts_.fill(0);
+  reg.retired_total_ns_.fill(0);
+  for (auto &retired : reg.retired_samples_) {
+    retired.clear();
+  }
+  for (ThreadState *state : reg.live_states_) {
+    for (PhaseAccum &accum : state->phases_) {
+      accum.count_.store(0, std::memory_order_relaxed);
+      accum.total_ns_.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+#else
+
+std::array<PerfPhaseStats, PERF_PHASE_COUNT> getPerfStats() {
+  return std::array<PerfPhaseStats, PERF_PHASE_COUNT>();
+}
+
+void resetPerfStats() {}
+
+#endif
+
+} // namespace robot_design
@@ -0,0 +1,66 @@
+#include <fcntl.h>
+#include <robot_design/prop.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace robot_design {
+
+TiledHeightfieldProp::TiledHeightfieldProp(Scalar friction,
+                                          const Vector3 &half_extents,
+                                          MatrixX heightfield, int tile_size)
+    : Prop(PropShape::TILED_HEIGHTFIELD, 0.0, friction, half_extents),
+      tile_size_(tile_size), rows_(heightfield.rows()),
+      cols_(heightfield.cols()), heightfield_(std::move(heightfield)) {
+  if (tile_size_ < 1) {
+    throw std::invalid_argument("Tile size must be positive");
+  }
+  data_ = heightfield_.data();
+}
+
+TiledHeightfieldProp::TiledHeightfieldProp(Scalar friction,
+                                          const Vector3 &half_extents,
+                                          const std::string &path, Index rows,
+                                          Index cols, int tile_size)
+    : Prop(PropShape::TILED_HEIGHTFIELD, 0.0, friction, half_extents),
+      tile_size_(tile_size), rows_(rows), cols_(cols) {
+  if (tile_size_ < 1) {
+    throw std::invalid_argument("Tile size must be positive");
+  }
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw std::runtime_error("Could not open heightfield file \"" + path +
+                             "\"");
+  }
+  mapped_size_ = static_cast<std::size_t>(rows) * cols * sizeof(Scalar);
+  struct stat file_stat;
+  if (::fstat(fd_, &file_stat) < 0 ||
+      static_cast<std::size_t>(file_stat.st_size) < mapped_size_) {
+    ::close(fd_);
+    throw std::runtime_error("Heightfield file \"" + path +
+                             "\" is smaller than rows * cols heights");
+  }
+  void *mapped = ::mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd_);
+    throw std::runtime_error("Could not map heightfield file \"" + path +
+                             "\"");
+  }
+  // Tile instantiation reads isolated blocks, do not read ahead
+  ::madvise(mapped, mapped_size_, MADV_RANDOM);
+  mapped_addr_ = mapped;
+  data_ = static_cast<const Scalar *>(mapped);
+}
+
+TiledHeightfieldProp::~TiledHeightfieldProp() {
+  if (mapped_addr_ != nullptr) {
+    ::munmap(mapped_addr_, mapped_size_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+} // namespace robot_design
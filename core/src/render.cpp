@@ -2,6 +2,7 @@
 #include <Eigen/Geometry>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <lodepng.h>
 #include <memory>
@@ -15,6 +16,12 @@ namespace robot_design {
 const VertexAttribute ATTRIB_POSITION(0, "model_position");
 const VertexAttribute ATTRIB_NORMAL(1, "model_normal");
 const VertexAttribute ATTRIB_TEX_COORD(2, "model_tex_coord");
+const VertexAttribute ATTRIB_INSTANCE_MODEL_MATRIX(3, "instance_model_matrix");
+const VertexAttribute ATTRIB_INSTANCE_TEX_COORDS_MATRIX(
+    7, "instance_tex_coords_matrix");
+const VertexAttribute ATTRIB_INSTANCE_COLOR(11, "instance_color");
+const VertexAttribute ATTRIB_INSTANCE_PROC_TEXTURE_TYPE(
+    12, "instance_proc_texture_type");
 
 Program::Program(const std::string &vertex_shader_source,
                  const std::string &fragment_shader_source)
@@ -65,6 +72,16 @@ Program::Program(const std::string &vertex_shader_source,
                        ATTRIB_NORMAL.name_.c_str());
   glBindAttribLocation(program_, ATTRIB_TEX_COORD.index_,
                        ATTRIB_TEX_COORD.name_.c_str());
+  // Per-instance attributes; binding names the shader does not declare is
+  // harmless
+  glBindAttribLocation(program_, ATTRIB_INSTANCE_MODEL_MATRIX.index_,
+                       ATTRIB_INSTANCE_MODEL_MATRIX.name_.c_str());
+  glBindAttribLocation(program_, ATTRIB_INSTANCE_TEX_COORDS_MATRIX.index_,
+                       ATTRIB_INSTANCE_TEX_COORDS_MATRIX.name_.c_str());
+  glBindAttribLocation(program_, ATTRIB_INSTANCE_COLOR.index_,
+                       ATTRIB_INSTANCE_COLOR.name_.c_str());
+  glBindAttribLocation(program_, ATTRIB_INSTANCE_PROC_TEXTURE_TYPE.index_,
+                       ATTRIB_INSTANCE_PROC_TEXTURE_TYPE.name_.c_str());
 
   glLinkProgram(program_);
   // Check for link errors
@@ -169,6 +186,52 @@ void Mesh::setIndices(const std::vector<GLint> &indices) {
   index_count_ = indices.size();
 }
 
+InstanceBuffer::InstanceBuffer() : buffer_(0) { glGenBuffers(1, &buffer_); }
+
+InstanceBuffer::~InstanceBuffer() { glDeleteBuffers(1, &buffer_); }
+
+void InstanceBuffer::bindToMesh(const Mesh &mesh) const {
+  mesh.bind();
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  GLsizei stride = sizeof(MeshInstance);
+  // A mat4 attribute occupies four consecutive vec4 attribute indices
+  for (GLuint j = 0; j < 4; ++j) {
+    GLuint index = ATTRIB_INSTANCE_MODEL_MATRIX.index_ + j;
+    glVertexAttribPointer(
+        index, 4, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<GLvoid *>(offsetof(MeshInstance, model_matrix_) +
+                                   4 * j * sizeof(GLfloat)));
+    glEnableVertexAttribArray(index);
+    glVertexAttribDivisor(index, 1);
+  }
+  for (GLuint j = 0; j < 4; ++j) {
+    GLuint index = ATTRIB_INSTANCE_TEX_COORDS_MATRIX.index_ + j;
+    glVertexAttribPointer(
+        index, 4, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<GLvoid *>(offsetof(MeshInstance, tex_coords_matrix_) +
+                                   4 * j * sizeof(GLfloat)));
+    glEnableVertexAttribArray(index);
+    glVertexAttribDivisor(index, 1);
+  }
+  glVertexAttribPointer(
+      ATTRIB_INSTANCE_COLOR.index_, 3, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<GLvoid *>(offsetof(MeshInstance, color_)));
+  glEnableVertexAttribArray(ATTRIB_INSTANCE_COLOR.index_);
+  glVertexAttribDivisor(ATTRIB_INSTANCE_COLOR.index_, 1);
+  glVertexAttribPointer(
+      ATTRIB_INSTANCE_PROC_TEXTURE_TYPE.index_, 1, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<GLvoid *>(offsetof(MeshInstance, proc_texture_type_)));
+  glEnableVertexAttribArray(ATTRIB_INSTANCE_PROC_TEXTURE_TYPE.index_);
+  glVertexAttribDivisor(ATTRIB_INSTANCE_PROC_TEXTURE_TYPE.index_, 1);
+}
+
+void InstanceBuffer::setData(const std::vector<MeshInstance> &instances) {
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  // Orphan the previous frame's storage instead of synchronizing with it
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(MeshInstance),
+               instances.data(), GL_STREAM_DRAW);
+}
+
 Texture2D::Texture2D(GLenum target, GLint level, GLint internal_format,
                      GLsizei width, GLsizei height, GLenum format, GLenum type,
                      const GLvoid *data)
@@ -269,6 +332,72 @@ Eigen::Matrix4f CameraParameters::getViewMatrix() const {
   return view_transform.matrix();
 }
 
+void SimulationSnapshot::capture(const Simulation &sim, double time) {
+  time_ = time;
+  robots_.resize(sim.getRobotCount());
+  link_transforms_.resize(sim.getRobotCount());
+  for (Index robot_idx = 0; robot_idx < sim.getRobotCount(); ++robot_idx) {
+    robots_[robot_idx] = sim.getRobot(robot_idx);
+    const Robot &robot = *robots_[robot_idx];
+    TransformVector &transforms = link_transforms_[robot_idx];
+    transforms.resize(robot.links_.size());
+    for (std::size_t link_idx = 0; link_idx < robot.links_.size(); ++link_idx) {
+      Matrix4 link_transform;
+      sim.getLinkTransform(robot_idx, link_idx, link_transform);
+      transforms[link_idx].rot_ =
+          Eigen::Quaternionf(link_transform.topLeftCorner<3, 3>().cast<float>());
+      transforms[link_idx].pos_ =
+          link_transform.topRightCorner<3, 1>().cast<float>();
+    }
+  }
+  props_.resize(sim.getPropCount());
+  prop_transforms_.resize(sim.getPropCount());
+  for (Index prop_idx = 0; prop_idx < sim.getPropCount(); ++prop_idx) {
+    props_[prop_idx] = sim.getProp(prop_idx);
+    Matrix4 prop_transform;
+    sim.getPropTransform(prop_idx, prop_transform);
+    prop_transforms_[prop_idx].rot_ =
+        Eigen::Quaternionf(prop_transform.topLeftCorner<3, 3>().cast<float>());
+    prop_transforms_[prop_idx].pos_ =
+        prop_transform.topRightCorner<3, 1>().cast<float>();
+  }
+}
+
+void SimulationSnapshot::interpolate(const SimulationSnapshot &a,
+                                     const SimulationSnapshot &b, double t,
+                                     SimulationSnapshot &result) {
+  result = b;
+  if (a.robots_.size() != b.robots_.size() ||
+      a.props_.size() != b.props_.size()) {
+    return;
+  }
+  float s = static_cast<float>(t);
+  for (std::size_t robot_idx = 0; robot_idx < b.robots_.size(); ++robot_idx) {
+    if (a.robots_[robot_idx] != b.robots_[robot_idx]) {
+      continue;
+    }
+    const TransformVector &transforms_a = a.link_transforms_[robot_idx];
+    TransformVector &transforms = result.link_transforms_[robot_idx];
+    for (std::size_t link_idx = 0; link_idx < transforms.size(); ++link_idx) {
+      transforms[link_idx].rot_ =
+          transforms_a[link_idx].rot_.slerp(s, transforms[link_idx].rot_);
+      transforms[link_idx].pos_ = (1.0f - s) * transforms_a[link_idx].pos_ +
+                                  s * transforms[link_idx].pos_;
+    }
+  }
+  for (std::size_t prop_idx = 0; prop_idx < b.props_.size(); ++prop_idx) {
+    if (a.props_[prop_idx] != b.props_[prop_idx]) {
+      continue;
+    }
+    result.prop_transforms_[prop_idx].rot_ = a.prop_transforms_[prop_idx].rot_
+        .slerp(s, result.prop_transforms_[prop_idx].rot_);
+    result.prop_transforms_[prop_idx].pos_ =
+        (1.0f - s) * a.prop_transforms_[prop_idx].pos_ +
+        s * result.prop_transforms_[prop_idx].pos_;
+  }
+  result.time_ = (1.0 - t) * a.time_ + t * b.time_;
+}
+
 DirectionalLight::DirectionalLight(const Eigen::Vector3f &color,
                                    const Eigen::Vector3f &dir,
                                    const Eigen::Vector3f &up, GLsizei sm_width,
@@ -571,6 +700,66 @@ std::shared_ptr<Mesh> makeCylinderEndMesh(int n_segments) {
   return mesh;
 }
 
+std::shared_ptr<Mesh> makeHeightfieldMesh(const Eigen::MatrixXf &heightfield) {
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<int> indices;
+
+  for (int j = 0; j < heightfield.cols() - 1; ++j) {
+    for (int i = 0; i < heightfield.rows() - 1; ++i) {
+      Eigen::Vector3f p00(i, heightfield(i, j), j);
+      Eigen::Vector3f p10(i + 1, heightfield(i + 1, j), j);
+      Eigen::Vector3f p01(i, heightfield(i, j + 1), j + 1);
+      Eigen::Vector3f p11(i + 1, heightfield(i + 1, j + 1), j + 1);
+      Eigen::Vector3f n00 = (p01 - p00).cross(p10 - p00).normalized();
+      Eigen::Vector3f n11 = (p10 - p11).cross(p01 - p11).normalized();
+
+      Eigen::Vector<float, 18> pos;
+      pos << p00, p01, p10, p11, p10, p01;
+      Eigen::Vector<float, 18> nor;
+      nor << n00, n00, n00, n11, n11, n11;
+      Eigen::Vector<int, 6> idx;
+      idx << 0, 1, 2, 3, 4, 5;
+      idx += Eigen::Vector<int, 6>::Constant(indices.size());
+
+      positions.insert(positions.end(), std::begin(pos), std::end(pos));
+      normals.insert(normals.end(), std::begin(nor), std::end(nor));
+      indices.insert(indices.end(), std::begin(idx), std::end(idx));
+    }
+  }
+
+  auto mesh = std::make_shared<Mesh>(GL_STATIC_DRAW);
+  mesh->setPositions(positions);
+  mesh->setNormals(normals);
+  mesh->setIndices(indices);
+  return mesh;
+}
+
+std::shared_ptr<Mesh> MeshCache::get(PrimitiveType type, int n_segments,
+                                     int n_rings) {
+  std::shared_ptr<Mesh> &mesh =
+      meshes_[std::make_tuple(static_cast<int>(type), n_segments, n_rings)];
+  if (!mesh) {
+    switch (type) {
+    case PrimitiveType::BOX:
+      mesh = makeBoxMesh();
+      break;
+    case PrimitiveType::TUBE:
+      mesh = makeTubeMesh(n_segments);
+      break;
+    case PrimitiveType::CAPSULE_END:
+      mesh = makeCapsuleEndMesh(n_segments, n_rings);
+      break;
+    case PrimitiveType::CYLINDER_END:
+      mesh = makeCylinderEndMesh(n_segments);
+      break;
+    default:
+      throw std::runtime_error("Unexpected primitive type");
+    }
+  }
+  return mesh;
+}
+
 std::shared_ptr<Texture2D> loadTexture(const std::string &path) {
   unsigned char *rgba_raw = nullptr;
   unsigned int width, height;
@@ -0,0 +1,65 @@
+#include <cstddef>
+#include <robot_design/robot.h>
+#include <utility>
+
+namespace robot_design {
+
+RobotData compileRobotData(std::shared_ptr<const Robot> robot) {
+  const auto &links = robot->links_;
+  std::size_t link_count = links.size();
+
+  RobotData data;
+  data.robot_ = std::move(robot);
+  data.parents_.reserve(link_count);
+  data.joint_types_.reserve(link_count);
+  data.shapes_.reserve(link_count);
+  data.lengths_.resize(link_count);
+  data.radii_.resize(link_count);
+  data.densities_.resize(link_count);
+  data.frictions_.resize(link_count);
+  data.link_masses_.resize(link_count);
+  data.joint_positions_.resize(link_count);
+  data.joint_rots_.reserve(link_count);
+  data.joint_axes_.resize(3, link_count);
+
+  for (std::size_t i = 0; i < link_count; ++i) {
+    const Link &link = links[i];
+    data.parents_.push_back(link.parent_);
+    data.joint_types_.push_back(link.joint_type_);
+    data.shapes_.push_back(link.shape_);
+    data.lengths_(i) = link.length_;
+    data.radii_(i) = link.radius_;
+    data.densities_(i) = link.density_;
+    data.frictions_(i) = link.friction_;
+    data.link_masses_(i) = link.length_ * link.density_;
+    data.joint_positions_(i) = link.joint_pos_;
+    data.joint_rots_.push_back(link.joint_rot_);
+    data.joint_axes_.col(i) = link.joint_axis_;
+  }
+
+  // Expand per-joint gains to per-dof vectors; only hinge joints are
+  // actuated, and they have exactly one dof (the base link has none)
+  int dof_count = 0;
+  for (std::size_t i = 1; i < link_count; ++i) {
+    if (links[i].joint_type_ == JointType::HINGE) {
+      ++dof_count;
+    }
+  }
+  data.dof_count_ = dof_count;
+  data.dof_kp_.resize(dof_count);
+  data.dof_kd_.resize(dof_count);
+  data.dof_torques_.resize(dof_count);
+  int dof_idx = 0;
+  for (std::size_t i = 1; i < link_count; ++i) {
+    if (links[i].joint_type_ == JointType::HINGE) {
+      data.dof_kp_(dof_idx) = links[i].joint_kp_;
+      data.dof_kd_(dof_idx) = links[i].joint_kd_;
+      data.dof_torques_(dof_idx) = links[i].joint_torque_;
+      ++dof_idx;
+    }
+  }
+
+  return data;
+}
+
+} // namespace robot_design
@@ -1,16 +1,25 @@
+#include <BulletCollision/CollisionShapes/btEmptyShape.h>
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 #include <Serialize/BulletWorldImporter/btMultiBodyWorldImporter.h>
+#include <cmath>
 #include <cstddef>
 #include <limits>
+#include <set>
+#include <robot_design/perf.h>
 #include <robot_design/prop.h>
 #include <robot_design/sim.h>
 #include <robot_design/types.h>
 #include <robot_design/utils.h>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace robot_design {
 
-BulletSimulation::BulletSimulation(Scalar time_step) : time_step_(time_step) {
+BulletSimulation::BulletSimulation(Scalar time_step,
+                                   const BulletSimulationProfile &profile)
+    : time_step_(time_step), profile_(profile) {
+  assert(profile.solver_iterations_ >= 1);
+  assert(profile.substep_count_ >= 1);
   collision_config_ = std::make_shared<btDefaultCollisionConfiguration>();
   dispatcher_ =
       std::make_shared<btCollisionDispatcher>(collision_config_.get());
@@ -23,6 +32,7 @@ BulletSimulation::BulletSimulation(Scalar time_step) : time_step_(time_step) {
       collision_config_.get());
   world_->setGravity(btVector3(0, -9.81, 0));
   world_->getDispatchInfo().m_deterministicOverlappingPairs = true;
+  world_->getSolverInfo().m_numIterations = profile_.solver_iterations_;
 }
 
 BulletSimulation::~BulletSimulation() {
@@ -36,33 +46,31 @@ BulletSimulation::~BulletSimulation() {
 
 Index BulletSimulation::addRobot(std::shared_ptr<const Robot> robot,
                                  const Vector3 &pos, const Quaternion &rot) {
-  robot_wrappers_.emplace_back(robot);
-  BulletRobotWrapper &wrapper = robot_wrappers_.back();
-  wrapper.col_shapes_.resize(robot->links_.size());
+  return addRobot(
+      std::make_shared<const RobotData>(compileRobotData(std::move(robot))),
+      pos, rot);
+}
 
-  for (std::size_t i = 0; i < robot->links_.size(); ++i) {
-    const Link &link = robot->links_[i];
+Index BulletSimulation::addRobot(std::shared_ptr<const RobotData> robot_data,
+                                 const Vector3 &pos, const Quaternion &rot) {
+  const RobotData &data = *robot_data;
+  std::size_t link_count = data.parents_.size();
+  robot_wrappers_.emplace_back(data.robot_);
+  BulletRobotWrapper &wrapper = robot_wrappers_.back();
+  wrapper.col_shapes_.resize(link_count);
 
-    std::shared_ptr<btCollisionShape> col_shape;
-    switch (link.shape_) {
-    case LinkShape::CAPSULE:
-      col_shape = std::make_shared<btCapsuleShapeX>(link.radius_, link.length_);
-      break;
-    case LinkShape::CYLINDER:
-      col_shape = std::make_shared<btCylinderShapeX>(
-          btVector3{0.5 * link.length_, link.radius_, link.radius_});
-      break;
-    default:
-      throw std::runtime_error("Unexpected link shape");
-    }
-    Scalar link_mass = link.length_ * link.density_;
+  for (std::size_t i = 0; i < link_count; ++i) {
+    std::shared_ptr<btCollisionShape> col_shape =
+        acquireLinkShape(data.shapes_[i], data.lengths_(i), data.radii_(i));
+    Scalar link_mass = data.link_masses_(i);
     btVector3 link_inertia;
     col_shape->calculateLocalInertia(link_mass, link_inertia);
 
     if (i == 0) {
-      assert(link.parent_ == -1 && link.joint_type_ == JointType::FREE);
+      assert(data.parents_[0] == -1 &&
+             data.joint_types_[0] == JointType::FREE);
       wrapper.multi_body_ = std::make_shared<btMultiBody>(
-          /*n_links=*/robot->links_.size() - 1,
+          /*n_links=*/link_count - 1,
           /*mass=*/link_mass,
           /*inertia=*/link_inertia,
           /*fixedBase=*/false,
@@ -71,18 +79,19 @@ Index BulletSimulation::addRobot(std::shared_ptr<const Robot> robot,
           /*q=*/bulletQuaternionFromEigen(rot),
           /*c=*/bulletVector3FromEigen(pos)));
     } else {
-      btQuaternion joint_rot = bulletQuaternionFromEigen(link.joint_rot_);
-      btVector3 joint_axis = bulletVector3FromEigen(link.joint_axis_);
+      btQuaternion joint_rot = bulletQuaternionFromEigen(data.joint_rots_[i]);
+      btVector3 joint_axis = bulletVector3FromEigen(data.joint_axes_.col(i));
       btVector3 joint_offset(
-          (link.joint_pos_ - 0.5) * robot->links_[link.parent_].length_, 0, 0);
-      btVector3 com_offset(0.5 * link.length_, 0, 0);
-      switch (link.joint_type_) {
+          (data.joint_positions_(i) - 0.5) * data.lengths_(data.parents_[i]),
+          0, 0);
+      btVector3 com_offset(0.5 * data.lengths_(i), 0, 0);
+      switch (data.joint_types_[i]) {
       case JointType::HINGE:
         wrapper.multi_body_->setupRevolute(
             /*i=*/i - 1, // Base link is already accounted for
             /*mass=*/link_mass,
             /*inertia=*/link_inertia,
-            /*parent=*/link.parent_ - 1,
+            /*parent=*/data.parents_[i] - 1,
             /*rotParentToThis=*/joint_rot,
             /*joint_axis=*/joint_axis,
             /*parentComToThisPivotOffset=*/joint_offset,
@@ -94,7 +103,7 @@ Index BulletSimulation::addRobot(std::shared_ptr<const Robot> robot,
             /*i=*/i - 1, // Base link is already accounted for
             /*mass=*/link_mass,
             /*inertia=*/link_inertia,
-            /*parent=*/link.parent_ - 1,
+            /*parent=*/data.parents_[i] - 1,
             /*rotParentToThis=*/joint_rot,
             /*parentComToThisPivotOffset=*/joint_offset,
             /*thisPivotToThisComOffset=*/com_offset);
@@ -115,31 +124,24 @@ Index BulletSimulation::addRobot(std::shared_ptr<const Robot> robot,
   wrapper.multi_body_->clearVelocities();
 
   int dof_count = wrapper.multi_body_->getNumDofs();
-  wrapper.joint_kp_.resize(dof_count);
-  wrapper.joint_kd_.resize(dof_count);
-  int dof_idx = 0;
-  // The base link (index 0) has no actuated degrees of freedom
-  for (std::size_t i = 1; i < robot->links_.size(); ++i) {
-    // The first non-base link in Bullet has index 0
-    const btMultibodyLink &link = wrapper.multi_body_->getLink(i - 1);
-    for (int j = 0; j < link.m_dofCount; ++j) {
-      wrapper.joint_kp_(dof_idx) = robot->links_[i].joint_kp_;
-      wrapper.joint_kd_(dof_idx) = robot->links_[i].joint_kd_;
-      ++dof_idx;
-    }
-  }
+  assert(dof_count == data.dof_count_);
+  // Gains are already expanded to per-dof vectors, copy them wholesale
+  wrapper.joint_kp_ = data.dof_kp_;
+  wrapper.joint_kd_ = data.dof_kd_;
   wrapper.joint_target_pos_ = VectorX::Zero(dof_count);
   wrapper.joint_target_vel_ = VectorX::Zero(dof_count);
+  wrapper.prev_joint_target_pos_ = VectorX::Zero(dof_count);
+  wrapper.prev_joint_target_vel_ = VectorX::Zero(dof_count);
   wrapper.joint_motor_torques_ = VectorX::Zero(dof_count);
 
   // Add collision objects to world
   wrapper.colliders_.resize(wrapper.col_shapes_.size());
   for (std::size_t i = 0; i < wrapper.col_shapes_.size(); ++i) {
-    auto collider = std::make_shared<btMultiBodyLinkCollider>(
-        wrapper.multi_body_.get(), static_cast<int>(i) - 1);
+    auto collider = acquireLinkCollider(wrapper.multi_body_.get(),
+                                        static_cast<int>(i) - 1);
     collider->setCollisionShape(wrapper.col_shapes_[i].get());
-    collider->setFriction(robot->links_[i].friction_);
-    collider->setUserPointer(const_cast<Robot *>(robot.get()));
+    collider->setFriction(data.frictions_(i));
+    collider->setUserPointer(const_cast<Robot *>(data.robot_.get()));
     world_->addCollisionObject(collider.get(),
                                /*collisionFilterGroup=*/1,
                                /*collisionFilterMask=*/3);
@@ -161,20 +163,28 @@ Index BulletSimulation::addRobot(std::shared_ptr<const Robot> robot,
                                                             local_origin);
 
   // Create joint motors
-  wrapper.motors_.reserve(wrapper.multi_body_->getNumDofs());
-  for (std::size_t i = 1; i < robot->links_.size(); ++i) {
+  wrapper.motors_.reserve(dof_count);
+  int dof_idx = 0;
+  // The base link (index 0) has no actuated degrees of freedom
+  for (std::size_t i = 1; i < link_count; ++i) {
     // The first non-base link in Bullet has index 0
     const btMultibodyLink &link = wrapper.multi_body_->getLink(i - 1);
-    for (int dof_idx = 0; dof_idx < link.m_dofCount; ++dof_idx) {
-      Scalar max_torque = robot->links_[i].joint_torque_;
+    for (int j = 0; j < link.m_dofCount; ++j) {
+      Scalar max_torque = data.dof_torques_(dof_idx);
+      // The impulse cap applies per solver pass, and substepping runs
+      // substep_count_ passes per step(); divide so the torque limit per
+      // top-level step is the same for every profile
       wrapper.motors_.push_back(std::make_shared<btMultiBodyJointMotor>(
           /*body=*/wrapper.multi_body_.get(), /*link=*/i - 1,
-          /*linkDoF=*/dof_idx, /*desiredVelocity=*/0.0,
-          /*maxMotorImpulse=*/max_torque * time_step_));
+          /*linkDoF=*/j, /*desiredVelocity=*/0.0,
+          /*maxMotorImpulse=*/max_torque * time_step_ /
+              profile_.substep_count_));
       world_->addMultiBodyConstraint(wrapper.motors_.back().get());
+      ++dof_idx;
     }
   }
 
+  contact_index_dirty_ = true;
   return robot_wrappers_.size() - 1;
 }
 
@@ -207,6 +217,21 @@ Index BulletSimulation::addProp(std::shared_ptr<const Prop> prop,
     // Heightfields are always static (zero mass)
     break;
   }
+  case PropShape::TILED_HEIGHTFIELD: {
+    auto tiled_prop = std::dynamic_pointer_cast<const TiledHeightfieldProp>(
+        prop);
+    // The wrapper's rigid body is an empty-shaped anchor carrying the prop
+    // transform; collision happens against tiles instantiated lazily around
+    // robots in updateTerrainTiles
+    wrapper.col_shape_ = std::make_shared<btEmptyShape>();
+    wrapper.tiled_terrain_ = std::make_shared<BulletTiledTerrain>();
+    wrapper.tiled_terrain_->prop_ = tiled_prop;
+    wrapper.tiled_terrain_->tile_row_count_ = static_cast<int>(
+        (tiled_prop->rows() - 2) / tiled_prop->tile_size_ + 1);
+    wrapper.tiled_terrain_->tile_col_count_ = static_cast<int>(
+        (tiled_prop->cols() - 2) / tiled_prop->tile_size_ + 1);
+    break;
+  }
   default:
     throw std::runtime_error("Unexpected prop shape");
   }
@@ -231,6 +256,7 @@ Index BulletSimulation::addProp(std::shared_ptr<const Prop> prop,
                        /*collisionFilterGroup=*/2,
                        /*collisionFilterMask=*/3);
 
+  contact_index_dirty_ = true;
   return prop_wrappers_.size() - 1;
 }
 
@@ -238,12 +264,14 @@ void BulletSimulation::removeRobot(Index robot_idx) {
   auto it = robot_wrappers_.begin() + robot_idx;
   unregisterRobotWrapper(*it);
   robot_wrappers_.erase(it);
+  contact_index_dirty_ = true;
 }
 
 void BulletSimulation::removeProp(Index prop_idx) {
   auto it = prop_wrappers_.begin() + prop_idx;
   unregisterPropWrapper(*it);
   prop_wrappers_.erase(it);
+  contact_index_dirty_ = true;
 }
 
 std::shared_ptr<const Robot> BulletSimulation::getRobot(Index robot_idx) const {
@@ -276,6 +304,41 @@ Index BulletSimulation::findPropIndex(const Prop &prop) const {
   return -1;
 }
 
+std::shared_ptr<btCollisionShape>
+BulletSimulation::acquireLinkShape(LinkShape shape, Scalar length,
+                                   Scalar radius) {
+  auto pool_it = shape_pool_.find(ShapePoolKey{shape, length, radius});
+  if (pool_it != shape_pool_.end() && !pool_it->second.empty()) {
+    std::shared_ptr<btCollisionShape> col_shape =
+        std::move(pool_it->second.back());
+    pool_it->second.pop_back();
+    return col_shape;
+  }
+  switch (shape) {
+  case LinkShape::CAPSULE:
+    return std::make_shared<btCapsuleShapeX>(radius, length);
+  case LinkShape::CYLINDER:
+    return std::make_shared<btCylinderShapeX>(
+        btVector3{0.5 * length, radius, radius});
+  default:
+    throw std::runtime_error("Unexpected link shape");
+  }
+}
+
+std::shared_ptr<btMultiBodyLinkCollider>
+BulletSimulation::acquireLinkCollider(btMultiBody *multi_body, int link_idx) {
+  if (!collider_pool_.empty()) {
+    std::shared_ptr<btMultiBodyLinkCollider> collider =
+        std::move(collider_pool_.back());
+    collider_pool_.pop_back();
+    // Retarget the recycled collider (these members are public in Bullet)
+    collider->m_multiBody = multi_body;
+    collider->m_link = link_idx;
+    return collider;
+  }
+  return std::make_shared<btMultiBodyLinkCollider>(multi_body, link_idx);
+}
+
 void BulletSimulation::unregisterRobotWrapper(
     BulletRobotWrapper &robot_wrapper) {
   for (auto motor : robot_wrapper.motors_) {
@@ -285,10 +348,29 @@ void BulletSimulation::unregisterRobotWrapper(
     world_->removeCollisionObject(collider.get());
   }
   world_->removeMultiBody(robot_wrapper.multi_body_.get());
+  // Recycle shapes and colliders for robots added later
+  const Robot &robot = *robot_wrapper.robot_;
+  for (std::size_t i = 0; i < robot_wrapper.col_shapes_.size(); ++i) {
+    const Link &link = robot.links_[i];
+    shape_pool_[ShapePoolKey{link.shape_, link.length_, link.radius_}]
+        .push_back(std::move(robot_wrapper.col_shapes_[i]));
+  }
+  robot_wrapper.col_shapes_.clear();
+  for (auto &collider : robot_wrapper.colliders_) {
+    collider->setUserPointer(nullptr);
+    collider_pool_.push_back(std::move(collider));
+  }
+  robot_wrapper.colliders_.clear();
 }
 
 void BulletSimulation::unregisterPropWrapper(BulletPropWrapper &prop_wrapper) {
   world_->removeRigidBody(prop_wrapper.rigid_body_.get());
+  if (prop_wrapper.tiled_terrain_) {
+    for (auto &entry : prop_wrapper.tiled_terrain_->tiles_) {
+      world_->removeRigidBody(entry.second.body_.get());
+    }
+    prop_wrapper.tiled_terrain_->tiles_.clear();
+  }
 }
 
 void BulletSimulation::getLinkTransform(Index robot_idx, Index link_idx,
@@ -376,6 +458,47 @@ void BulletSimulation::getJointMotorTorques(Index robot_idx,
   motor_torques = robot_wrappers_[robot_idx].joint_motor_torques_;
 }
 
+void BulletSimulation::getFullState(Index robot_idx,
+                                    Ref<VectorX> state) const {
+  const BulletRobotWrapper &wrapper = robot_wrappers_[robot_idx];
+  const btMultiBody &multi_body = *wrapper.multi_body_;
+  int dof_count = multi_body.getNumDofs();
+
+  Eigen::Map<Matrix4>(state.segment<16>(0).data()) =
+      eigenMatrix4FromBullet(multi_body.getBaseWorldTransform());
+  state.segment<3>(16) = eigenVector3FromBullet(multi_body.getBaseOmega());
+  state.segment<3>(19) = eigenVector3FromBullet(multi_body.getBaseVel());
+
+  // Joint positions and velocities in one pass over the links
+  int offset = 0;
+  for (int link_idx = 0; link_idx < multi_body.getNumLinks(); ++link_idx) {
+    const btMultibodyLink &link = multi_body.getLink(link_idx);
+    // Every joint type in use has m_posVarCount == m_dofCount
+    for (int dof_idx = 0; dof_idx < link.m_dofCount; ++dof_idx) {
+      state(FULL_STATE_BASE_SIZE + offset) =
+          multi_body.getJointPosMultiDof(link_idx)[dof_idx];
+      state(FULL_STATE_BASE_SIZE + dof_count + offset) =
+          multi_body.getJointVelMultiDof(link_idx)[dof_idx];
+      ++offset;
+    }
+  }
+  state.segment(FULL_STATE_BASE_SIZE + 2 * dof_count, dof_count) =
+      wrapper.joint_motor_torques_;
+}
+
+VectorX &BulletSimulation::refreshFullStateBuffer(Index robot_idx) {
+  if (full_state_buffers_.size() < robot_wrappers_.size()) {
+    full_state_buffers_.resize(robot_wrappers_.size());
+  }
+  VectorX &buffer = full_state_buffers_[robot_idx];
+  int state_size = FULL_STATE_BASE_SIZE + 3 * getRobotDofCount(robot_idx);
+  if (buffer.size() != state_size) {
+    buffer.resize(state_size);
+  }
+  getFullState(robot_idx, buffer);
+  return buffer;
+}
+
 void BulletSimulation::setJointTargets(Index robot_idx,
                                        const Ref<const VectorX> &target) {
   BulletRobotWrapper &wrapper = robot_wrappers_[robot_idx];
@@ -470,26 +593,69 @@ void BulletSimulation::getRobotWorldAABB(Index robot_idx, Ref<Vector3> lower,
   }
 }
 
-bool BulletSimulation::robotHasCollision(Index robot_idx) const {
-  const Robot *robot = robot_wrappers_[robot_idx].robot_.get();
+void BulletSimulation::rebuildContactIndex() const {
+  robot_contacts_.resize(robot_wrappers_.size());
+  robot_has_collision_.assign(robot_wrappers_.size(), false);
+  for (auto &contacts : robot_contacts_) {
+    contacts.clear();
+  }
+
+  // Map each robot's user pointer back to its index in robot_wrappers_
+  std::unordered_map<const void *, Index> robot_indices;
+  robot_indices.reserve(robot_wrappers_.size());
+  for (std::size_t i = 0; i < robot_wrappers_.size(); ++i) {
+    robot_indices.emplace(robot_wrappers_[i].robot_.get(), i);
+  }
+
   int manifold_count = dispatcher_->getNumManifolds();
   for (int i = 0; i < manifold_count; ++i) {
     const btPersistentManifold *manifold =
         dispatcher_->getManifoldByIndexInternal(i);
-    if (manifold->getBody0()->getUserPointer() == robot ||
-        manifold->getBody1()->getUserPointer() == robot) {
-      // Contact involves at least one of the robot's bodies
-      int contact_count = manifold->getNumContacts();
-      for (int j = 0; j < contact_count; ++j) {
-        const btManifoldPoint &manifold_point = manifold->getContactPoint(j);
-        if (manifold_point.getDistance() < 0) {
+    auto it0 = robot_indices.find(manifold->getBody0()->getUserPointer());
+    auto it1 = robot_indices.find(manifold->getBody1()->getUserPointer());
+    if (it0 == robot_indices.end() && it1 == robot_indices.end()) {
+      // Contact involves none of the robots' bodies
+      continue;
+    }
+    int contact_count = manifold->getNumContacts();
+    for (int j = 0; j < contact_count; ++j) {
+      const btManifoldPoint &manifold_point = manifold->getContactPoint(j);
+      ContactPoint contact_point{
+          eigenVector3FromBullet(manifold_point.getPositionWorldOnB()),
+          eigenVector3FromBullet(manifold_point.m_normalWorldOnB),
+          manifold_point.getDistance()};
+      if (it0 != robot_indices.end()) {
+        robot_contacts_[it0->second].push_back(contact_point);
+        if (contact_point.distance_ < 0) {
           // Bodies are intersecting
-          return true;
+          robot_has_collision_[it0->second] = true;
+        }
+      }
+      if (it1 != robot_indices.end() && it1 != it0) {
+        robot_contacts_[it1->second].push_back(contact_point);
+        if (contact_point.distance_ < 0) {
+          robot_has_collision_[it1->second] = true;
         }
       }
     }
   }
-  return false;
+
+  contact_index_dirty_ = false;
+}
+
+bool BulletSimulation::robotHasCollision(Index robot_idx) const {
+  if (contact_index_dirty_) {
+    rebuildContactIndex();
+  }
+  return robot_has_collision_[robot_idx];
+}
+
+const std::vector<ContactPoint> &
+BulletSimulation::getRobotContacts(Index robot_idx) const {
+  if (contact_index_dirty_) {
+    rebuildContactIndex();
+  }
+  return robot_contacts_[robot_idx];
 }
 
 Scalar BulletSimulation::getTimeStep() const { return time_step_; }
@@ -502,7 +668,124 @@ void BulletSimulation::setGravity(const Ref<const Vector3> &gravity) {
   world_->setGravity(bulletVector3FromEigen(gravity));
 }
 
+void BulletSimulation::setFullStateSerialization(
+    bool full_state_serialization) {
+  full_state_serialization_ = full_state_serialization;
+}
+
+bool BulletSimulation::getFullStateSerialization() const {
+  return full_state_serialization_;
+}
+
+void BulletSimulation::saveCompactState(BulletCompactState &state) const {
+  state.robot_states_.resize(robot_wrappers_.size());
+  for (std::size_t i = 0; i < robot_wrappers_.size(); ++i) {
+    const btMultiBody &multi_body = *robot_wrappers_[i].multi_body_;
+    int pos_var_count = multi_body.getNumPosVars();
+    int dof_count = multi_body.getNumDofs();
+    VectorX &robot_state = state.robot_states_[i];
+    // Resizing is a no-op after the first save, the state size is constant
+    robot_state.resize(13 + pos_var_count + dof_count);
+    const btTransform &base_transform = multi_body.getBaseWorldTransform();
+    robot_state.segment<3>(0) =
+        eigenVector3FromBullet(base_transform.getOrigin());
+    Quaternion base_rot = eigenQuaternionFromBullet(
+        base_transform.getRotation());
+    robot_state.segment<4>(3) = base_rot.coeffs();
+    robot_state.segment<3>(7) = eigenVector3FromBullet(multi_body.getBaseOmega());
+    robot_state.segment<3>(10) = eigenVector3FromBullet(multi_body.getBaseVel());
+    int pos_offset = 13;
+    int vel_offset = 13 + pos_var_count;
+    for (int link_idx = 0; link_idx < multi_body.getNumLinks(); ++link_idx) {
+      const btMultibodyLink &link = multi_body.getLink(link_idx);
+      for (int k = 0; k < link.m_posVarCount; ++k) {
+        robot_state(pos_offset++) =
+            multi_body.getJointPosMultiDof(link_idx)[k];
+      }
+      for (int k = 0; k < link.m_dofCount; ++k) {
+        robot_state(vel_offset++) =
+            multi_body.getJointVelMultiDof(link_idx)[k];
+      }
+    }
+  }
+
+  state.prop_states_.resize(prop_wrappers_.size());
+  for (std::size_t i = 0; i < prop_wrappers_.size(); ++i) {
+    const btRigidBody &rigid_body = *prop_wrappers_[i].rigid_body_;
+    VectorX &prop_state = state.prop_states_[i];
+    prop_state.resize(13);
+    const btTransform &transform = rigid_body.getCenterOfMassTransform();
+    prop_state.segment<3>(0) = eigenVector3FromBullet(transform.getOrigin());
+    Quaternion rot = eigenQuaternionFromBullet(transform.getRotation());
+    prop_state.segment<4>(3) = rot.coeffs();
+    prop_state.segment<3>(7) =
+        eigenVector3FromBullet(rigid_body.getAngularVelocity());
+    prop_state.segment<3>(10) =
+        eigenVector3FromBullet(rigid_body.getLinearVelocity());
+  }
+
+  state.valid_ = true;
+}
+
+void BulletSimulation::restoreCompactState(const BulletCompactState &state) {
+  assert(state.robot_states_.size() == robot_wrappers_.size());
+  assert(state.prop_states_.size() == prop_wrappers_.size());
+  for (std::size_t i = 0; i < robot_wrappers_.size(); ++i) {
+    btMultiBody &multi_body = *robot_wrappers_[i].multi_body_;
+    const VectorX &robot_state = state.robot_states_[i];
+    Quaternion base_rot;
+    base_rot.coeffs() = robot_state.segment<4>(3);
+    multi_body.setBaseWorldTransform(btTransform(
+        /*q=*/bulletQuaternionFromEigen(base_rot),
+        /*c=*/bulletVector3FromEigen(robot_state.segment<3>(0))));
+    multi_body.setBaseOmega(bulletVector3FromEigen(robot_state.segment<3>(7)));
+    multi_body.setBaseVel(bulletVector3FromEigen(robot_state.segment<3>(10)));
+    int pos_var_count = multi_body.getNumPosVars();
+    int pos_offset = 13;
+    int vel_offset = 13 + pos_var_count;
+    for (int link_idx = 0; link_idx < multi_body.getNumLinks(); ++link_idx) {
+      const btMultibodyLink &link = multi_body.getLink(link_idx);
+      for (int k = 0; k < link.m_posVarCount; ++k) {
+        multi_body.getJointPosMultiDof(link_idx)[k] =
+            robot_state(pos_offset++);
+      }
+      for (int k = 0; k < link.m_dofCount; ++k) {
+        multi_body.getJointVelMultiDof(link_idx)[k] =
+            robot_state(vel_offset++);
+      }
+    }
+    multi_body.clearForcesAndTorques();
+    // Bring cached link and collider transforms in sync with the joint state
+    btAlignedObjectArray<btQuaternion> scratch_q;
+    btAlignedObjectArray<btVector3> scratch_m;
+    multi_body.forwardKinematics(scratch_q, scratch_m);
+    btAlignedObjectArray<btQuaternion> world_to_local;
+    btAlignedObjectArray<btVector3> local_origin;
+    multi_body.updateCollisionObjectWorldTransforms(world_to_local,
+                                                    local_origin);
+  }
+
+  for (std::size_t i = 0; i < prop_wrappers_.size(); ++i) {
+    btRigidBody &rigid_body = *prop_wrappers_[i].rigid_body_;
+    const VectorX &prop_state = state.prop_states_[i];
+    Quaternion rot;
+    rot.coeffs() = prop_state.segment<4>(3);
+    rigid_body.setCenterOfMassTransform(btTransform(
+        /*q=*/bulletQuaternionFromEigen(rot),
+        /*c=*/bulletVector3FromEigen(prop_state.segment<3>(0))));
+    rigid_body.setAngularVelocity(
+        bulletVector3FromEigen(prop_state.segment<3>(7)));
+    rigid_body.setLinearVelocity(
+        bulletVector3FromEigen(prop_state.segment<3>(10)));
+    rigid_body.clearForces();
+  }
+}
+
 void BulletSimulation::saveState() {
+  if (!full_state_serialization_) {
+    saveCompactState(compact_state_);
+    return;
+  }
   auto serializer = std::make_shared<btDefaultSerializer>();
   int ser_flags = serializer->getSerializationFlags();
   serializer->setSerializationFlags(ser_flags | BT_SERIALIZE_CONTACT_MANIFOLDS);
@@ -521,31 +804,394 @@ void BulletSimulation::saveState() {
 }
 
 void BulletSimulation::restoreState() {
+  if (!full_state_serialization_) {
+    if (compact_state_.valid_) {
+      restoreCompactState(compact_state_);
+      contact_index_dirty_ = true;
+    }
+    return;
+  }
   if (saved_state_.bullet_file_ != nullptr) {
     auto importer = std::make_shared<btMultiBodyWorldImporter>(world_.get());
     importer->setImporterFlags(eRESTORE_EXISTING_OBJECTS);
     importer->convertAllObjects(saved_state_.bullet_file_.get());
+    contact_index_dirty_ = true;
+  }
+}
+
+void BulletSimulation::saveState(int slot) {
+  assert(slot >= 0 && slot < static_cast<int>(state_ring_.size()));
+  // Resizing inside saveCompactState is a no-op after the slot's first use
+  saveCompactState(state_ring_[slot]);
+}
+
+void BulletSimulation::restoreState(int slot) {
+  assert(slot >= 0 && slot < static_cast<int>(state_ring_.size()));
+  if (state_ring_[slot].valid_) {
+    restoreCompactState(state_ring_[slot]);
+    contact_index_dirty_ = true;
+  }
+}
+
+void BulletSimulation::setStateRingSize(int slot_count) {
+  assert(slot_count >= 0);
+  state_ring_.resize(slot_count);
+}
+
+int BulletSimulation::getStateRingSize() const {
+  return static_cast<int>(state_ring_.size());
+}
+
+void BulletSimulation::cloneStateInto(BulletSimulation &other) const {
+  saveCompactState(other.clone_scratch_state_);
+  other.restoreCompactState(other.clone_scratch_state_);
+  other.contact_index_dirty_ = true;
+}
+
+int BulletSimulation::getPackedStateSize() const {
+  int size = 0;
+  for (const BulletRobotWrapper &wrapper : robot_wrappers_) {
+    size += 13 + wrapper.multi_body_->getNumPosVars() +
+            wrapper.multi_body_->getNumDofs();
+  }
+  size += 13 * static_cast<int>(prop_wrappers_.size());
+  return size;
+}
+
+void BulletSimulation::getPackedState(Ref<VectorX> packed_state) const {
+  assert(packed_state.size() == getPackedStateSize());
+  saveCompactState(clone_scratch_state_);
+  int offset = 0;
+  for (const VectorX &robot_state : clone_scratch_state_.robot_states_) {
+    packed_state.segment(offset, robot_state.size()) = robot_state;
+    offset += robot_state.size();
+  }
+  for (const VectorX &prop_state : clone_scratch_state_.prop_states_) {
+    packed_state.segment(offset, prop_state.size()) = prop_state;
+    offset += prop_state.size();
+  }
+}
+
+void BulletSimulation::setPackedState(const Ref<const VectorX> &packed_state) {
+  assert(packed_state.size() == getPackedStateSize());
+  BulletCompactState &state = clone_scratch_state_;
+  state.robot_states_.resize(robot_wrappers_.size());
+  state.prop_states_.resize(prop_wrappers_.size());
+  int offset = 0;
+  for (std::size_t i = 0; i < robot_wrappers_.size(); ++i) {
+    const btMultiBody &multi_body = *robot_wrappers_[i].multi_body_;
+    int block_size =
+        13 + multi_body.getNumPosVars() + multi_body.getNumDofs();
+    state.robot_states_[i] = packed_state.segment(offset, block_size);
+    offset += block_size;
+  }
+  for (std::size_t i = 0; i < prop_wrappers_.size(); ++i) {
+    state.prop_states_[i] = packed_state.segment(offset, 13);
+    offset += 13;
+  }
+  state.valid_ = true;
+  restoreCompactState(state);
+  contact_index_dirty_ = true;
+}
+
+// Terrain tiles are activated within this distance of a robot's AABB and
+// evicted after being outside it for this many steps
+constexpr Scalar TERRAIN_TILE_MARGIN = 1.0;
+constexpr int TERRAIN_TILE_EVICT_STEPS = 256;
+
+void BulletSimulation::instantiateTerrainTile(BulletPropWrapper &prop_wrapper,
+                                              int tile_row, int tile_col) {
+  BulletTiledTerrain &terrain = *prop_wrapper.tiled_terrain_;
+  const TiledHeightfieldProp &prop = *terrain.prop_;
+  Index rows = prop.rows();
+  Index cols = prop.cols();
+  int tile_size = prop.tile_size_;
+  Index row_start = static_cast<Index>(tile_row) * tile_size;
+  Index col_start = static_cast<Index>(tile_col) * tile_size;
+  // Adjacent tiles share one sample row/column so the surface is seamless
+  Index tile_rows = std::min<Index>(tile_size + 1, rows - row_start);
+  Index tile_cols = std::min<Index>(tile_size + 1, cols - col_start);
+
+  BulletTerrainTile tile;
+  tile.heights_.resize(tile_rows, tile_cols);
+  for (Index j = 0; j < tile_cols; ++j) {
+    for (Index i = 0; i < tile_rows; ++i) {
+      tile.heights_(i, j) = prop.height(row_start + i, col_start + j);
+    }
+  }
+  // Same sample spacing, height range, and vertical centering as the
+  // monolithic heightfield shape
+  auto shape = std::make_shared<btHeightfieldTerrainShape>(
+      tile_rows, tile_cols, tile.heights_.data(),
+      /*heightScale=*/1.0, /*minHeight=*/0.0, /*maxHeight=*/1.0,
+      /*upAxis=*/1, /*heightDataType=*/PHY_FLOAT, /*flipQuadEdges=*/false);
+  Vector3 local_scaling =
+      (2.0 * prop.half_extents_).array() /
+      Vector3(rows - 1, 1.0, cols - 1).array();
+  shape->setLocalScaling(bulletVector3FromEigen(local_scaling));
+  shape->buildAccelerator();
+  tile.shape_ = shape;
+
+  // Offset of the tile's center from the full heightfield's center, in the
+  // prop's local frame
+  Scalar offset_x = (row_start + (tile_rows - 1) / 2.0 - (rows - 1) / 2.0) *
+                    local_scaling.x();
+  Scalar offset_z = (col_start + (tile_cols - 1) / 2.0 - (cols - 1) / 2.0) *
+                    local_scaling.z();
+  btRigidBody::btRigidBodyConstructionInfo tile_body_info(
+      /*mass=*/0.0,
+      /*motionState=*/nullptr,
+      /*collisionShape=*/tile.shape_.get(),
+      /*localInertia=*/btVector3(0, 0, 0));
+  tile_body_info.m_friction = prop.friction_;
+  tile.body_ = std::make_shared<btRigidBody>(tile_body_info);
+  tile.body_->setCenterOfMassTransform(
+      prop_wrapper.rigid_body_->getCenterOfMassTransform() *
+      btTransform(btQuaternion::getIdentity(),
+                  btVector3(offset_x, 0.0, offset_z)));
+  world_->addRigidBody(tile.body_.get(),
+                       /*collisionFilterGroup=*/2,
+                       /*collisionFilterMask=*/3);
+  terrain.tiles_.emplace(tile_row * terrain.tile_col_count_ + tile_col,
+                         std::move(tile));
+  contact_index_dirty_ = true;
+}
+
+void BulletSimulation::updateTerrainTiles() {
+  // Expanded robot AABBs, gathered once for all tiled props
+  std::vector<std::pair<Vector3, Vector3>> robot_aabbs;
+  for (BulletPropWrapper &prop_wrapper : prop_wrappers_) {
+    if (!prop_wrapper.tiled_terrain_) {
+      continue;
+    }
+    if (robot_aabbs.empty()) {
+      robot_aabbs.reserve(robot_wrappers_.size());
+      for (Index robot_idx = 0; robot_idx < getRobotCount(); ++robot_idx) {
+        Vector3 lower, upper;
+        getRobotWorldAABB(robot_idx, lower, upper);
+        robot_aabbs.emplace_back(
+            (lower.array() - TERRAIN_TILE_MARGIN).matrix(),
+            (upper.array() + TERRAIN_TILE_MARGIN).matrix());
+      }
+    }
+    BulletTiledTerrain &terrain = *prop_wrapper.tiled_terrain_;
+    const TiledHeightfieldProp &prop = *terrain.prop_;
+    Scalar scale_x = 2.0 * prop.half_extents_.x() / (prop.rows() - 1);
+    Scalar scale_z = 2.0 * prop.half_extents_.z() / (prop.cols() - 1);
+    btTransform world_to_prop =
+        prop_wrapper.rigid_body_->getCenterOfMassTransform().inverse();
+
+    // Tiles overlapping any expanded robot AABB (in the prop's local frame)
+    std::set<int> required_tiles;
+    for (const auto &aabb : robot_aabbs) {
+      Scalar local_min_x = std::numeric_limits<Scalar>::infinity();
+      Scalar local_max_x = -std::numeric_limits<Scalar>::infinity();
+      Scalar local_min_z = std::numeric_limits<Scalar>::infinity();
+      Scalar local_max_z = -std::numeric_limits<Scalar>::infinity();
+      for (int corner = 0; corner < 8; ++corner) {
+        Vector3 world_corner((corner & 1) ? aabb.second.x() : aabb.first.x(),
+                             (corner & 2) ? aabb.second.y() : aabb.first.y(),
+                             (corner & 4) ? aabb.second.z() : aabb.first.z());
+        btVector3 local_corner =
+            world_to_prop * bulletVector3FromEigen(world_corner);
+        local_min_x = std::min<Scalar>(local_min_x, local_corner.x());
+        local_max_x = std::max<Scalar>(local_max_x, local_corner.x());
+        local_min_z = std::min<Scalar>(local_min_z, local_corner.z());
+        local_max_z = std::max<Scalar>(local_max_z, local_corner.z());
+      }
+      // Convert to sample coordinates, then to tile indices
+      Scalar row_min = local_min_x / scale_x + (prop.rows() - 1) / 2.0;
+      Scalar row_max = local_max_x / scale_x + (prop.rows() - 1) / 2.0;
+      Scalar col_min = local_min_z / scale_z + (prop.cols() - 1) / 2.0;
+      Scalar col_max = local_max_z / scale_z + (prop.cols() - 1) / 2.0;
+      if (row_max < 0.0 || col_max < 0.0 || row_min > prop.rows() - 1 ||
+          col_min > prop.cols() - 1) {
+        continue;
+      }
+      int tile_row_min = std::max(
+          0, static_cast<int>(std::floor(row_min / prop.tile_size_)));
+      int tile_row_max = std::min(
+          terrain.tile_row_count_ - 1,
+          static_cast<int>(std::floor(row_max / prop.tile_size_)));
+      int tile_col_min = std::max(
+          0, static_cast<int>(std::floor(col_min / prop.tile_size_)));
+      int tile_col_max = std::min(
+          terrain.tile_col_count_ - 1,
+          static_cast<int>(std::floor(col_max / prop.tile_size_)));
+      for (int tile_row = tile_row_min; tile_row <= tile_row_max;
+           ++tile_row) {
+        for (int tile_col = tile_col_min; tile_col <= tile_col_max;
+             ++tile_col) {
+          required_tiles.insert(tile_row * terrain.tile_col_count_ +
+                                tile_col);
+        }
+      }
+    }
+
+    for (int tile_key : required_tiles) {
+      auto it = terrain.tiles_.find(tile_key);
+      if (it != terrain.tiles_.end()) {
+        it->second.stale_steps_ = 0;
+      } else {
+        instantiateTerrainTile(prop_wrapper,
+                               tile_key / terrain.tile_col_count_,
+                               tile_key % terrain.tile_col_count_);
+      }
+    }
+    // Age and evict tiles no robot is near, returning their memory
+    for (auto it = terrain.tiles_.begin(); it != terrain.tiles_.end();) {
+      if (required_tiles.count(it->first) == 0 &&
+          ++it->second.stale_steps_ >= TERRAIN_TILE_EVICT_STEPS) {
+        world_->removeRigidBody(it->second.body_.get());
+        it = terrain.tiles_.erase(it);
+        contact_index_dirty_ = true;
+      } else {
+        ++it;
+      }
+    }
   }
 }
 
 void BulletSimulation::step() {
-  // Run joint PD controllers
-  for (Index robot_idx = 0; robot_idx < getRobotCount(); ++robot_idx) {
-    BulletRobotWrapper &wrapper = robot_wrappers_[robot_idx];
-    int dof_count = wrapper.multi_body_->getNumDofs();
-    for (int dof_idx = 0; dof_idx < dof_count; ++dof_idx) {
-      btMultiBodyJointMotor &motor = *wrapper.motors_[dof_idx];
-      motor.setPositionTarget(wrapper.joint_target_pos_[dof_idx],
-                              wrapper.joint_kp_[dof_idx]);
-      motor.setVelocityTarget(wrapper.joint_target_vel_[dof_idx],
-                              wrapper.joint_kd_[dof_idx]);
+  RD_PERF_SCOPE(PerfPhase::SIM_STEP);
+  updateTerrainTiles();
+  int substep_count = profile_.substep_count_;
+  Scalar substep_time = time_step_ / substep_count;
+  for (int substep = 0; substep < substep_count; ++substep) {
+    // Run joint PD controllers; with substepping enabled, targets are
+    // interpolated from the previous step's targets so high-gain motors
+    // do not see the full target jump at the first substep
+    Scalar t = static_cast<Scalar>(substep + 1) / substep_count;
+    for (Index robot_idx = 0; robot_idx < getRobotCount(); ++robot_idx) {
+      BulletRobotWrapper &wrapper = robot_wrappers_[robot_idx];
+      int dof_count = wrapper.multi_body_->getNumDofs();
+      for (int dof_idx = 0; dof_idx < dof_count; ++dof_idx) {
+        btMultiBodyJointMotor &motor = *wrapper.motors_[dof_idx];
+        Scalar target_pos = wrapper.joint_target_pos_[dof_idx];
+        Scalar target_vel = wrapper.joint_target_vel_[dof_idx];
+        if (substep_count > 1) {
+          target_pos = (1 - t) * wrapper.prev_joint_target_pos_[dof_idx] +
+                       t * target_pos;
+          target_vel = (1 - t) * wrapper.prev_joint_target_vel_[dof_idx] +
+                       t * target_vel;
+        }
+        motor.setPositionTarget(target_pos, wrapper.joint_kp_[dof_idx]);
+        motor.setVelocityTarget(target_vel, wrapper.joint_kd_[dof_idx]);
+      }
+    }
+    world_->stepSimulation(substep_time, 0, substep_time);
+  }
+  if (substep_count > 1) {
+    for (auto &wrapper : robot_wrappers_) {
+      wrapper.prev_joint_target_pos_ = wrapper.joint_target_pos_;
+      wrapper.prev_joint_target_vel_ = wrapper.joint_target_vel_;
     }
   }
-  world_->stepSimulation(time_step_, 0, time_step_);
   world_->forwardKinematics(); // Update m_cachedWorldTransform for every link
+  contact_index_dirty_ = true;
   // TODO: read back joint torques
 }
 
+SimulationBatch::SimulationBatch(int world_count,
+                                 const MakeBulletSimFunction &make_sim_fn) {
+  assert(world_count >= 1);
+  worlds_.reserve(world_count);
+  for (int i = 0; i < world_count; ++i) {
+    worlds_.push_back(make_sim_fn());
+  }
+
+  const BulletSimulation &first_world = *worlds_[0];
+  assert(first_world.getRobotCount() == 1);
+  dof_count_ = first_world.getRobotDofCount(0);
+
+  // Worlds are identical, so the per-dof control modes can be derived once
+  // from the first world's robot
+  const Robot &robot = *first_world.getRobot(0);
+  joint_control_modes_.reserve(dof_count_);
+  for (std::size_t i = 1; i < robot.links_.size(); ++i) {
+    const Link &link = robot.links_[i];
+    // Only hinge joints are actuated, and they have exactly one dof
+    if (link.joint_type_ == JointType::HINGE) {
+      joint_control_modes_.push_back(link.joint_control_mode_);
+    }
+  }
+  assert(static_cast<int>(joint_control_modes_.size()) == dof_count_);
+
+  joint_target_pos_ = MatrixX::Zero(dof_count_, world_count);
+  joint_target_vel_ = MatrixX::Zero(dof_count_, world_count);
+  joint_pos_ = MatrixX::Zero(dof_count_, world_count);
+  joint_vel_ = MatrixX::Zero(dof_count_, world_count);
+  getJointStateAll(joint_pos_, joint_vel_);
+}
+
+Index SimulationBatch::getWorldCount() const { return worlds_.size(); }
+
+int SimulationBatch::getDofCount() const { return dof_count_; }
+
+BulletSimulation &SimulationBatch::getWorld(Index world_idx) {
+  return *worlds_[world_idx];
+}
+
+const BulletSimulation &SimulationBatch::getWorld(Index world_idx) const {
+  return *worlds_[world_idx];
+}
+
+void SimulationBatch::setJointTargetsAll(const Ref<const MatrixX> &targets) {
+  assert(targets.rows() == dof_count_ &&
+         targets.cols() == static_cast<Index>(worlds_.size()));
+  Scalar time_step = worlds_[0]->getTimeStep();
+  // Compute the PD targets for every world in one pass over the matrices
+  for (int dof_idx = 0; dof_idx < dof_count_; ++dof_idx) {
+    switch (joint_control_modes_[dof_idx]) {
+    case JointControlMode::POSITION:
+      joint_target_pos_.row(dof_idx) = targets.row(dof_idx);
+      joint_target_vel_.row(dof_idx).setZero();
+      break;
+    case JointControlMode::VELOCITY:
+      // TODO: allow changing this scaling factor
+      joint_target_vel_.row(dof_idx) = 5.0 * targets.row(dof_idx);
+      joint_target_pos_.row(dof_idx) =
+          joint_pos_.row(dof_idx) + joint_target_vel_.row(dof_idx) * time_step;
+      break;
+    default:
+      throw std::runtime_error("Unexpected joint control mode");
+    }
+  }
+  for (std::size_t k = 0; k < worlds_.size(); ++k) {
+    worlds_[k]->setJointTargetPositions(0, joint_target_pos_.col(k));
+    worlds_[k]->setJointTargetVelocities(0, joint_target_vel_.col(k));
+  }
+}
+
+void SimulationBatch::getJointStateAll(Ref<MatrixX> pos,
+                                       Ref<MatrixX> vel) const {
+  for (std::size_t k = 0; k < worlds_.size(); ++k) {
+    worlds_[k]->getJointPositions(0, pos.col(k));
+    worlds_[k]->getJointVelocities(0, vel.col(k));
+  }
+}
+
+void SimulationBatch::saveStateAll() {
+  for (auto &world : worlds_) {
+    world->saveState();
+  }
+}
+
+void SimulationBatch::restoreStateAll() {
+  for (auto &world : worlds_) {
+    world->restoreState();
+  }
+  getJointStateAll(joint_pos_, joint_vel_);
+}
+
+void SimulationBatch::stepAll() {
+  for (auto &world : worlds_) {
+    world->step();
+  }
+  // Cache the joint state, setJointTargetsAll needs it for velocity control
+  getJointStateAll(joint_pos_, joint_vel_);
+}
+
 bool BulletSimulation::OverlapFilterCallback::needBroadphaseCollision(
     btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1) const {
   // Ignore collisions between links rigidly attached to the same ancestor link
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <fcntl.h>
+#include <robot_design/trajectory_log.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace robot_design {
+
+constexpr char TRAJECTORY_LOG_MAGIC[4] = {'R', 'D', 'T', 'L'};
+constexpr std::uint32_t TRAJECTORY_LOG_VERSION = 1;
+
+namespace {
+
+// FNV-1a over the raw bytes of a value
+void hashBytes(std::uint64_t &digest, const void *data, std::size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    digest ^= bytes[i];
+    digest *= 0x100000001b3ull;
+  }
+}
+
+template <typename T> void hashValue(std::uint64_t &digest, const T &value) {
+  hashBytes(digest, &value, sizeof(T));
+}
+
+} // namespace
+
+std::uint64_t computeRobotDigest(const Robot &robot) {
+  std::uint64_t digest = 0xcbf29ce484222325ull; // FNV offset basis
+  for (const Link &link : robot.links_) {
+    hashValue(digest, link.parent_);
+    hashValue(digest, link.joint_type_);
+    hashValue(digest, link.joint_pos_);
+    hashBytes(digest, link.joint_rot_.coeffs().data(), 4 * sizeof(Scalar));
+    hashBytes(digest, link.joint_axis_.data(), 3 * sizeof(Scalar));
+    hashValue(digest, link.shape_);
+    hashValue(digest, link.length_);
+    hashValue(digest, link.radius_);
+    hashValue(digest, link.density_);
+    hashValue(digest, link.friction_);
+    hashValue(digest, link.joint_kp_);
+    hashValue(digest, link.joint_kd_);
+    hashValue(digest, link.joint_torque_);
+    hashValue(digest, link.joint_control_mode_);
+  }
+  return digest;
+}
+
+TrajectoryLogWriter::TrajectoryLogWriter(const std::string &path,
+                                         const Simulation &sim,
+                                         Index robot_idx,
+                                         int chunk_frame_count)
+    : path_(path), robot_idx_(robot_idx),
+      chunk_frame_count_(chunk_frame_count) {
+  int dof_count = sim.getRobotDofCount(robot_idx);
+  frame_size_ = Simulation::FULL_STATE_BASE_SIZE + 3 * dof_count;
+  robot_digest_ = computeRobotDigest(*sim.getRobot(robot_idx));
+  time_step_ = sim.getTimeStep();
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Could not open file \"" + path +
+                             "\" for writing");
+  }
+  try {
+    remapForCapacity(chunk_frame_count_);
+  } catch (...) {
+    ::close(fd_);
+    fd_ = -1;
+    throw;
+  }
+
+  TrajectoryLogHeader header = {};
+  std::memcpy(header.magic_, TRAJECTORY_LOG_MAGIC,
+              sizeof(TRAJECTORY_LOG_MAGIC));
+  header.version_ = TRAJECTORY_LOG_VERSION;
+  header.scalar_size_ = sizeof(Scalar);
+  header.frame_size_ = frame_size_;
+  header.frame_count_ = 0;
+  header.robot_digest_ = robot_digest_;
+  header.time_step_ = time_step_;
+  std::memcpy(data_, &header, sizeof(header));
+}
+
+TrajectoryLogWriter::~TrajectoryLogWriter() { close(); }
+
+void TrajectoryLogWriter::remapForCapacity(std::size_t frame_capacity) {
+  std::size_t new_size = sizeof(TrajectoryLogHeader) +
+                         frame_capacity * frame_size_ * sizeof(Scalar);
+  if (::ftruncate(fd_, new_size) != 0) {
+    throw std::runtime_error("Could not grow file \"" + path_ + "\"");
+  }
+  void *mapped =
+      ::mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("Could not map file \"" + path_ + "\"");
+  }
+  // Drop the old mapping only once the replacement exists, so a growth
+  // failure (e.g. disk full) leaves the recorded frames mapped and close()
+  // can still finalize the header
+  if (data_) {
+    ::munmap(data_, mapped_size_);
+  }
+  data_ = static_cast<char *>(mapped);
+  mapped_size_ = new_size;
+  frame_capacity_ = frame_capacity;
+}
+
+void TrajectoryLogWriter::recordStep(const Simulation &sim) {
+  if (frame_count_ == frame_capacity_) {
+    remapForCapacity(frame_capacity_ + chunk_frame_count_);
+  }
+  // Pack the state directly into the mapped region
+  Scalar *frame =
+      reinterpret_cast<Scalar *>(data_ + sizeof(TrajectoryLogHeader)) +
+      frame_count_ * frame_size_;
+  Eigen::Map<VectorX> state(frame, frame_size_);
+  sim.getFullState(robot_idx_, state);
+  ++frame_count_;
+}
+
+void TrajectoryLogWriter::close() {
+  if (fd_ < 0) {
+    return;
+  }
+  // Finalize the frame count and trim the unused tail of the last chunk
+  if (data_) {
+    reinterpret_cast<TrajectoryLogHeader *>(data_)->frame_count_ =
+        frame_count_;
+    ::munmap(data_, mapped_size_);
+    data_ = nullptr;
+  }
+  std::size_t exact_size = sizeof(TrajectoryLogHeader) +
+                           frame_count_ * frame_size_ * sizeof(Scalar);
+  ::ftruncate(fd_, exact_size);
+  ::close(fd_);
+  fd_ = -1;
+}
+
+TrajectoryLogReader::TrajectoryLogReader(const std::string &path) {
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw std::runtime_error("Could not open file \"" + path +
+                             "\" for reading");
+  }
+  struct stat file_stat;
+  if (::fstat(fd_, &file_stat) != 0 ||
+      static_cast<std::size_t>(file_stat.st_size) <
+          sizeof(TrajectoryLogHeader)) {
+    ::close(fd_);
+    throw std::runtime_error("File \"" + path +
+                             "\" is not a trajectory log file");
+  }
+  mapped_size_ = file_stat.st_size;
+  void *mapped = ::mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd_);
+    throw std::runtime_error("Could not map file \"" + path + "\"");
+  }
+  data_ = static_cast<char *>(mapped);
+  header_ = reinterpret_cast<const TrajectoryLogHeader *>(data_);
+
+  if (std::memcmp(header_->magic_, TRAJECTORY_LOG_MAGIC,
+                  sizeof(TRAJECTORY_LOG_MAGIC)) != 0 ||
+      header_->version_ != TRAJECTORY_LOG_VERSION ||
+      header_->scalar_size_ != sizeof(Scalar) ||
+      mapped_size_ < sizeof(TrajectoryLogHeader) +
+                         header_->frame_count_ * header_->frame_size_ *
+                             sizeof(Scalar)) {
+    ::munmap(data_, mapped_size_);
+    ::close(fd_);
+    throw std::runtime_error("File \"" + path +
+                             "\" is not a valid trajectory log file");
+  }
+}
+
+TrajectoryLogReader::~TrajectoryLogReader() {
+  ::munmap(data_, mapped_size_);
+  ::close(fd_);
+}
+
+Eigen::Map<const MatrixX> TrajectoryLogReader::getFrames() const {
+  return Eigen::Map<const MatrixX>(
+      reinterpret_cast<const Scalar *>(data_ + sizeof(TrajectoryLogHeader)),
+      header_->frame_size_, header_->frame_count_);
+}
+
+} // namespace robot_design
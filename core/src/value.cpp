@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <robot_design/value.h>
+#include <stdexcept>
+
+namespace robot_design {
+
+FusedMLPValueEstimator::FusedMLPValueEstimator(
+    int obs_size, const std::vector<int> &hidden_sizes, Scalar learning_rate,
+    int batch_size, int epoch_count)
+    : obs_size_(obs_size), learning_rate_(learning_rate),
+      batch_size_(batch_size), epoch_count_(epoch_count) {
+  // Hidden layers plus a scalar output layer
+  std::vector<int> layer_sizes;
+  layer_sizes.push_back(obs_size);
+  layer_sizes.insert(layer_sizes.end(), hidden_sizes.begin(),
+                     hidden_sizes.end());
+  layer_sizes.push_back(1);
+
+  std::mt19937 generator(0);
+  for (std::size_t l = 0; l + 1 < layer_sizes.size(); ++l) {
+    int input_size = layer_sizes[l];
+    int output_size = layer_sizes[l + 1];
+    // He initialization, appropriate for ReLU activations
+    std::normal_distribution<Scalar> dist(0.0,
+                                          std::sqrt(2.0 / input_size));
+    LayerMatrix weight(output_size, input_size);
+    for (int i = 0; i < output_size; ++i) {
+      for (int j = 0; j < input_size; ++j) {
+        weight(i, j) = dist(generator);
+      }
+    }
+    weights_.push_back(std::move(weight));
+    biases_.push_back(VectorX::Zero(output_size));
+    weight_moment1_.push_back(LayerMatrix::Zero(output_size, input_size));
+    weight_moment2_.push_back(LayerMatrix::Zero(output_size, input_size));
+    bias_moment1_.push_back(VectorX::Zero(output_size));
+    bias_moment2_.push_back(VectorX::Zero(output_size));
+  }
+}
+
+void FusedMLPValueEstimator::getObservation(const Simulation &sim,
+                                            Ref<VectorX> obs) const {
+  // The observation is the packed full state of the first robot; see
+  // Simulation::getFullState for the layout
+  sim.getFullState(/*robot_idx=*/0, obs);
+}
+
+void FusedMLPValueEstimator::estimateValue(const MatrixX &obs,
+                                           Ref<VectorX> value_est) const {
+  // One batched matrix product per layer over the whole observation matrix
+  MatrixX activations = obs;
+  for (std::size_t l = 0; l < weights_.size(); ++l) {
+    MatrixX preact = weights_[l] * activations;
+    preact.colwise() += biases_[l];
+    if (l + 1 < weights_.size()) {
+      activations = preact.cwiseMax(0.0); // ReLU
+    } else {
+      activations = std::move(preact);
+    }
+  }
+  value_est = activations.transpose();
+}
+
+void FusedMLPValueEstimator::train(const MatrixX &obs,
+                                   const Ref<const VectorX> &value) {
+  constexpr Scalar BETA1 = 0.9;
+  constexpr Scalar BETA2 = 0.999;
+  constexpr Scalar EPSILON = 1e-8;
+
+  int example_count = obs.cols();
+  std::vector<int> order(example_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 generator(shuffle_seed_++);
+
+  std::size_t layer_count = weights_.size();
+  std::vector<MatrixX> activations(layer_count + 1);
+  for (int epoch = 0; epoch < epoch_count_; ++epoch) {
+    std::shuffle(order.begin(), order.end(), generator);
+    for (int start = 0; start < example_count; start += batch_size_) {
+      int len = std::min(batch_size_, example_count - start);
+
+      // Gather the minibatch
+      MatrixX batch_obs(obs.rows(), len);
+      VectorX batch_value(len);
+      for (int i = 0; i < len; ++i) {
+        batch_obs.col(i) = obs.col(order[start + i]);
+        batch_value(i) = value(order[start + i]);
+      }
+
+      // Forward pass, keeping each layer's activations for backprop
+      activations[0] = std::move(batch_obs);
+      for (std::size_t l = 0; l < layer_count; ++l) {
+        MatrixX preact = weights_[l] * activations[l];
+        preact.colwise() += biases_[l];
+        if (l + 1 < layer_count) {
+          activations[l + 1] = preact.cwiseMax(0.0); // ReLU
+        } else {
+          activations[l + 1] = std::move(preact);
+        }
+      }
+
+      // Backward pass on the mean squared error loss, with an Adam update
+      // per parameter block
+      ++adam_step_count_;
+      Scalar moment1_scale = 1.0 - std::pow(BETA1, adam_step_count_);
+      Scalar moment2_scale = 1.0 - std::pow(BETA2, adam_step_count_);
+      MatrixX grad_preact =
+          (2.0 / len) * (activations[layer_count] - batch_value.transpose());
+      for (std::size_t l = layer_count; l-- > 0;) {
+        LayerMatrix grad_weight = grad_preact * activations[l].transpose();
+        VectorX grad_bias = grad_preact.rowwise().sum();
+        if (l > 0) {
+          // ReLU derivative masks the gradient of the previous activations
+          grad_preact = (weights_[l].transpose() * grad_preact).array() *
+                        (activations[l].array() > 0.0).cast<Scalar>();
+        }
+
+        weight_moment1_[l] =
+            BETA1 * weight_moment1_[l] + (1.0 - BETA1) * grad_weight;
+        weight_moment2_[l] = BETA2 * weight_moment2_[l] +
+                             (1.0 - BETA2) * grad_weight.cwiseAbs2();
+        weights_[l].array() -=
+            learning_rate_ * (weight_moment1_[l].array() / moment1_scale) /
+            ((weight_moment2_[l].array() / moment2_scale).sqrt() + EPSILON);
+
+        bias_moment1_[l] = BETA1 * bias_moment1_[l] + (1.0 - BETA1) * grad_bias;
+        bias_moment2_[l] =
+            BETA2 * bias_moment2_[l] + (1.0 - BETA2) * grad_bias.cwiseAbs2();
+        biases_[l].array() -=
+            learning_rate_ * (bias_moment1_[l].array() / moment1_scale) /
+            ((bias_moment2_[l].array() / moment2_scale).sqrt() + EPSILON);
+      }
+    }
+  }
+}
+
+void FusedMLPValueEstimator::setLayerParams(int layer_idx,
+                                            const Ref<const MatrixX> &weight,
+                                            const Ref<const VectorX> &bias) {
+  LayerMatrix &layer_weight = weights_.at(layer_idx);
+  if (weight.rows() != layer_weight.rows() ||
+      weight.cols() != layer_weight.cols() ||
+      bias.size() != biases_[layer_idx].size()) {
+    throw std::invalid_argument("Layer parameter shapes do not match");
+  }
+  layer_weight = weight;
+  biases_[layer_idx] = bias;
+}
+
+MatrixX FusedMLPValueEstimator::getLayerWeight(int layer_idx) const {
+  return weights_.at(layer_idx);
+}
+
+VectorX FusedMLPValueEstimator::getLayerBias(int layer_idx) const {
+  return biases_.at(layer_idx);
+}
+
+} // namespace robot_design
@@ -0,0 +1,270 @@
+// Microbenchmarks for the hot paths the optimization pipeline depends on:
+// simulation stepping and state snapshots, robot insertion, MPPI updates,
+// graph matching/rewriting/hashing on the shipped grammars, and input
+// sampling. Results are printed as one JSON object per line (ops/sec plus
+// peak RSS) so regressions can be gated on the numbers.
+
+#include <args.hxx>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <robot_design/graph.h>
+#include <robot_design/optim.h>
+#include <robot_design/robot.h>
+#include <robot_design/sim.h>
+#include <robot_design/types.h>
+#include <robot_design/value.h>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+using namespace robot_design;
+
+static std::size_t getPeakRSSBytes() {
+  struct rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in kilobytes on Linux
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
+
+// Runs fn repeatedly for at least min_seconds (after one warmup call) and
+// reports the result as a JSON line
+template <typename Fn>
+static void runBenchmark(const std::string &name, double min_seconds,
+                         Fn &&fn) {
+  using Clock = std::chrono::steady_clock;
+  fn(); // Warmup
+  long long iterations = 0;
+  auto start_time = Clock::now();
+  double seconds = 0.0;
+  while (seconds < min_seconds) {
+    fn();
+    ++iterations;
+    seconds = std::chrono::duration<double>(Clock::now() - start_time).count();
+  }
+  std::cout << "{\"benchmark\": \"" << name << "\""
+            << ", \"iterations\": " << iterations
+            << ", \"seconds\": " << seconds
+            << ", \"ops_per_sec\": " << (iterations / seconds)
+            << ", \"peak_rss_bytes\": " << getPeakRSSBytes() << "}"
+            << std::endl;
+}
+
+// Free-floating capsule chain with hinge joints, used so the simulation
+// benchmarks cover a controlled range of robot sizes
+static std::shared_ptr<const Robot> makeChainRobot(int link_count) {
+  auto robot = std::make_shared<Robot>();
+  robot->links_.emplace_back(
+      /*parent=*/-1, JointType::FREE, /*joint_pos=*/0.0,
+      Quaternion::Identity(), Vector3::UnitZ(), LinkShape::CAPSULE,
+      /*length=*/0.2, /*radius=*/0.05, /*density=*/1.0, /*friction=*/0.9,
+      /*joint_kp=*/0.0, /*joint_kd=*/0.0, /*joint_torque=*/0.0,
+      JointControlMode::POSITION, Color{0.45f, 0.5f, 0.55f},
+      Color{1.0f, 0.5f, 0.3f}, "", "");
+  for (int i = 1; i < link_count; ++i) {
+    robot->links_.emplace_back(
+        /*parent=*/i - 1, JointType::HINGE, /*joint_pos=*/1.0,
+        Quaternion::Identity(), Vector3::UnitY(), LinkShape::CAPSULE,
+        /*length=*/0.2, /*radius=*/0.05, /*density=*/1.0, /*friction=*/0.9,
+        /*joint_kp=*/2.0, /*joint_kd=*/0.1, /*joint_torque=*/1.0,
+        JointControlMode::POSITION, Color{0.45f, 0.5f, 0.55f},
+        Color{1.0f, 0.5f, 0.3f}, "", "");
+  }
+  return robot;
+}
+
+static std::shared_ptr<BulletSimulation>
+makeChainSim(const std::shared_ptr<const RobotData> &robot_data) {
+  auto sim = std::make_shared<BulletSimulation>();
+  auto floor = std::make_shared<Prop>(PropShape::BOX, /*density=*/0.0,
+                                      /*friction=*/0.9,
+                                      Vector3(10.0, 1.0, 10.0));
+  sim->addProp(floor, Vector3(0.0, -1.0, 0.0), Quaternion::Identity());
+  sim->addRobot(robot_data, Vector3(0.0, 0.5, 0.0), Quaternion::Identity());
+  return sim;
+}
+
+// Mirrors make_initial_graph in examples/design_search
+static Graph makeInitialGraph() {
+  Graph graph;
+  Node node;
+  node.name_ = "robot";
+  node.attrs_.label_ = "robot";
+  graph.nodes_.push_back(node);
+  return graph;
+}
+
+// Grows a benchmark target graph by repeatedly applying the first applicable
+// (rule, match) combination; deterministic for a given grammar
+static Graph makeTargetGraph(const std::vector<Rule> &rules,
+                             int application_count) {
+  Graph graph = makeInitialGraph();
+  for (int i = 0; i < application_count; ++i) {
+    bool applied = false;
+    for (const Rule &rule : rules) {
+      for (const GraphMapping &match : findMatches(rule.lhs_, graph)) {
+        if (checkRuleApplicability(rule, graph, match)) {
+          graph = applyRule(rule, graph, match);
+          applied = true;
+          break;
+        }
+      }
+      if (applied) {
+        break;
+      }
+    }
+    if (!applied) {
+      break;
+    }
+  }
+  return graph;
+}
+
+int main(int argc, char **argv) {
+  args::ArgumentParser parser("Robot design microbenchmark suite.");
+  args::HelpFlag help_flag(parser, "help", "Display this help message",
+                           {'h', "help"});
+  args::ValueFlag<std::string> grammar_flag(
+      parser, "grammar", "Grammar file (.dot)", {'g', "grammar"},
+      "data/designs/grammar_apr30.dot");
+  args::ValueFlag<double> min_seconds_flag(
+      parser, "min_seconds", "Minimum measurement time per benchmark",
+      {'t', "min_seconds"}, 1.0);
+
+  try {
+    parser.ParseCLI(argc, argv);
+  } catch (const args::Help &) {
+    std::cout << parser;
+    return 0;
+  } catch (const args::ParseError &e) {
+    std::cerr << e.what() << std::endl;
+    std::cerr << parser;
+    return 1;
+  }
+
+  double min_seconds = args::get(min_seconds_flag);
+
+  // Simulation benchmarks across several robot sizes
+  for (int link_count : {4, 8, 16}) {
+    auto robot = makeChainRobot(link_count);
+    auto robot_data =
+        std::make_shared<const RobotData>(compileRobotData(robot));
+    std::string suffix = "/links=" + std::to_string(link_count);
+
+    {
+      auto sim = makeChainSim(robot_data);
+      runBenchmark("sim_step" + suffix, min_seconds, [&]() { sim->step(); });
+    }
+    {
+      auto sim = makeChainSim(robot_data);
+      sim->saveState();
+      runBenchmark("sim_save_state" + suffix, min_seconds,
+                   [&]() { sim->saveState(); });
+      runBenchmark("sim_restore_state" + suffix, min_seconds,
+                   [&]() { sim->restoreState(); });
+    }
+    {
+      auto sim = std::make_shared<BulletSimulation>();
+      runBenchmark("sim_add_remove_robot" + suffix, min_seconds, [&]() {
+        Index robot_idx = sim->addRobot(robot_data, Vector3(0.0, 0.5, 0.0),
+                                        Quaternion::Identity());
+        sim->removeRobot(robot_idx);
+      });
+    }
+  }
+
+  // MPPI update latency versus sample and thread count
+  {
+    auto robot = makeChainRobot(8);
+    auto robot_data =
+        std::make_shared<const RobotData>(compileRobotData(robot));
+    int dof_count = robot_data->dof_count_;
+    int hardware_threads =
+        std::max(1u, std::thread::hardware_concurrency());
+    SumOfSquaresObjective objective;
+    objective.base_vel_weight_ = Vector6::Ones();
+    auto value_estimator = std::make_shared<NullValueEstimator>();
+    auto input_sampler = std::make_shared<DefaultInputSampler>();
+    MakeSimFunction make_sim_fn = [&]() { return makeChainSim(robot_data); };
+
+    for (auto [sample_count, thread_count] :
+         std::vector<std::pair<int, int>>{
+             {64, 1}, {64, hardware_threads}, {256, hardware_threads}}) {
+      MPPIOptimizer optimizer(
+          /*kappa=*/1.0, /*discount_factor=*/0.99, dof_count, /*interval=*/4,
+          /*horizon=*/16, sample_count, thread_count, /*seed=*/0, make_sim_fn,
+          objective, value_estimator, input_sampler);
+      runBenchmark("mppi_update/samples=" + std::to_string(sample_count) +
+                       "/threads=" + std::to_string(thread_count),
+                   min_seconds, [&]() { optimizer.update(); });
+    }
+  }
+
+  // Graph benchmarks on the shipped grammar
+  {
+    std::vector<Graph> rule_graphs = loadGraphs(args::get(grammar_flag));
+    std::vector<Rule> rules;
+    rules.reserve(rule_graphs.size());
+    for (const Graph &rule_graph : rule_graphs) {
+      rules.push_back(createRuleFromGraph(rule_graph));
+    }
+    Graph target = makeTargetGraph(rules, 16);
+
+    runBenchmark("find_matches", min_seconds, [&]() {
+      for (const Rule &rule : rules) {
+        findMatches(rule.lhs_, target);
+      }
+    });
+
+    // Pick one applicable (rule, match) combination to apply repeatedly
+    const Rule *apply_rule_ptr = nullptr;
+    GraphMapping apply_match;
+    for (const Rule &rule : rules) {
+      for (const GraphMapping &match : findMatches(rule.lhs_, target)) {
+        if (checkRuleApplicability(rule, target, match)) {
+          apply_rule_ptr = &rule;
+          apply_match = match;
+          break;
+        }
+      }
+      if (apply_rule_ptr) {
+        break;
+      }
+    }
+    if (apply_rule_ptr) {
+      Graph result;
+      runBenchmark("apply_rule", min_seconds, [&]() {
+        applyRuleInto(*apply_rule_ptr, target, apply_match, result);
+      });
+    }
+
+    runBenchmark("hash_graph", min_seconds, [&]() {
+      invalidateGraphHash(target);
+      hashGraph(target);
+    });
+  }
+
+  // Input sampler benchmarks
+  {
+    int dof_count = 16;
+    int horizon = 64;
+    MatrixX input_seq(dof_count, horizon);
+    MatrixX last_input_seq = MatrixX::Zero(dof_count, horizon);
+    MatrixX history = MatrixX::Zero(dof_count, horizon);
+    unsigned int seed = 0;
+    DefaultInputSampler default_sampler;
+    runBenchmark("sample_input_sequence/default", min_seconds, [&]() {
+      default_sampler.sampleInputSequence(input_seq, seed++, 0,
+                                          last_input_seq, history);
+    });
+    VectorizedInputSampler vectorized_sampler;
+    runBenchmark("sample_input_sequence/vectorized", min_seconds, [&]() {
+      vectorized_sampler.sampleInputSequence(input_seq, seed++, 0,
+                                             last_input_seq, history);
+    });
+  }
+
+  return 0;
+}
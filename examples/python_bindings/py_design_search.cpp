@@ -0,0 +1,52 @@
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <robot_design/design_search.h>
+
+namespace py = pybind11;
+namespace rd = robot_design;
+
+void initDesignSearch(py::module &m) {
+  py::class_<rd::MPPIDesignEvaluator,
+             std::shared_ptr<rd::MPPIDesignEvaluator>>(m,
+                                                       "MPPIDesignEvaluator")
+      // Only SumOfSquaresObjective and DotProductObjective are supported by the
+      // Python bindings for now
+      .def(py::init<rd::Scalar, rd::Scalar, int, int, int, int, int, int,
+                    const rd::MPPIDesignEvaluator::MakeRobotSimFunction &,
+                    const rd::SumOfSquaresObjective &,
+                    const std::shared_ptr<const rd::InputSampler> &>())
+      .def(py::init<rd::Scalar, rd::Scalar, int, int, int, int, int, int,
+                    const rd::MPPIDesignEvaluator::MakeRobotSimFunction &,
+                    const rd::DotProductObjective &,
+                    const std::shared_ptr<const rd::InputSampler> &>())
+      .def("__call__", &rd::MPPIDesignEvaluator::operator(),
+           py::call_guard<py::gil_scoped_release>());
+
+  py::class_<rd::DesignSearch, std::shared_ptr<rd::DesignSearch>>(
+      m, "DesignSearch")
+      // Each search worker receives a private copy of the evaluator
+      .def(py::init([](const rd::Graph &initial_graph,
+                       const std::vector<rd::Rule> &rules,
+                       int max_rule_seq_len, int max_tries, int thread_count,
+                       unsigned int seed,
+                       const rd::MPPIDesignEvaluator &evaluator) {
+        rd::MakeDesignEvaluatorFunction make_evaluator_fn =
+            [evaluator]() -> rd::DesignEvaluator { return evaluator; };
+        return std::make_shared<rd::DesignSearch>(
+            initial_graph, rules, max_rule_seq_len, max_tries, thread_count,
+            seed, make_evaluator_fn);
+      }))
+      // The GIL is held only while entering and leaving run(); the search
+      // workers reacquire it for configuration and result callbacks
+      .def("run", &rd::DesignSearch::run,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_result_callback", &rd::DesignSearch::setResultCallback)
+      .def_property_readonly("node_count", &rd::DesignSearch::getNodeCount)
+      .def_property_readonly("evaluation_count",
+                             &rd::DesignSearch::getEvaluationCount)
+      .def_property_readonly("best_result", &rd::DesignSearch::getBestResult)
+      .def_property_readonly("best_rule_sequence",
+                             &rd::DesignSearch::getBestRuleSequence);
+}
@@ -0,0 +1,27 @@
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <robot_design/distributed.h>
+
+namespace py = pybind11;
+namespace rd = robot_design;
+
+void initDistributed(py::module &m) {
+  py::class_<rd::RolloutWorkerServer,
+             std::shared_ptr<rd::RolloutWorkerServer>>(m,
+                                                       "RolloutWorkerServer")
+      // Only SumOfSquaresObjective and DotProductObjective are supported by the
+      // Python bindings for now
+      .def(py::init<int, rd::Scalar, int, int, const rd::MakeSimFunction &,
+                    const rd::SumOfSquaresObjective &,
+                    const std::shared_ptr<const rd::ValueEstimator> &,
+                    const std::shared_ptr<const rd::InputSampler> &>())
+      .def(py::init<int, rd::Scalar, int, int, const rd::MakeSimFunction &,
+                    const rd::DotProductObjective &,
+                    const std::shared_ptr<const rd::ValueEstimator> &,
+                    const std::shared_ptr<const rd::InputSampler> &>())
+      .def("serve", &rd::RolloutWorkerServer::serve,
+           py::call_guard<py::gil_scoped_release>())
+      .def("serve_once", &rd::RolloutWorkerServer::serveOnce,
+           py::call_guard<py::gil_scoped_release>());
+}
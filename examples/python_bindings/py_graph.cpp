@@ -95,9 +95,19 @@ void initGraph(py::module &m) {
       .def_readwrite("common_to_rhs", &rd::Rule::common_to_rhs_);
 
   m.def("load_graphs", &rd::loadGraphs);
-  m.def("build_robot", &rd::buildRobot);
+  // Route robot building through the shared cache (revisited designs are
+  // common during search), but hand out a copy: callers mutate the result
+  // (e.g. build_normalized_robot), which must not corrupt the cached entry
+  m.def("build_robot", [](const rd::Graph &graph) {
+    return rd::Robot(*rd::buildRobotCached(graph));
+  });
   m.def("create_rule_from_graph", &rd::createRuleFromGraph);
-  m.def("find_matches", &rd::findMatches);
+  m.def("find_matches",
+        static_cast<std::vector<rd::GraphMapping> (*)(
+            const rd::Graph &, const rd::Graph &)>(&rd::findMatches));
   m.def("check_rule_applicability", &rd::checkRuleApplicability);
   m.def("apply_rule", &rd::applyRule);
+  m.def("expand_graph", &rd::expandGraph, py::arg("graph"), py::arg("rules"),
+        py::arg("thread_count") = 0,
+        py::call_guard<py::gil_scoped_release>());
 }
@@ -1,6 +1,7 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <robot_design/episode.h>
 #include <robot_design/optim.h>
 
 namespace py = pybind11;
@@ -46,11 +47,52 @@ void initOptim(py::module &m) {
            py::call_guard<py::gil_scoped_release>())
       .def("get_sample_count", &rd::MPPIOptimizer::getSampleCount)
       .def("set_sample_count", &rd::MPPIOptimizer::setSampleCount)
-      .def_readwrite("input_sequence", &rd::MPPIOptimizer::input_sequence_);
+      .def("set_rollout_pruning", &rd::MPPIOptimizer::setRolloutPruning,
+           py::arg("enabled"), py::arg("margin") = 5.0)
+      .def("set_pipelined_value_estimation",
+           &rd::MPPIOptimizer::setPipelinedValueEstimation, py::arg("enabled"),
+           py::arg("chunk_count") = 8)
+      .def("add_remote_worker", &rd::MPPIOptimizer::addRemoteWorker,
+           py::arg("host"), py::arg("port"), py::arg("sample_share"))
+      .def_readwrite("input_sequence", &rd::MPPIOptimizer::input_sequence_)
+      // Zero-copy views over optimizer state; input_sequence_view and
+      // history_view stay valid for the optimizer's lifetime, while
+      // final_obs_view is invalidated by set_sample_count
+      .def_property_readonly(
+          "input_sequence_view",
+          [](rd::MPPIOptimizer &optimizer) -> Eigen::Ref<rd::MatrixX> {
+            return optimizer.input_sequence_;
+          },
+          py::return_value_policy::reference_internal)
+      .def_property_readonly("history_view", &rd::MPPIOptimizer::getHistory,
+                             py::return_value_policy::reference_internal)
+      .def_property_readonly("final_obs_view", &rd::MPPIOptimizer::getFinalObs,
+                             py::return_value_policy::reference_internal);
+
+  py::class_<rd::EpisodeRunner, std::shared_ptr<rd::EpisodeRunner>>(
+      m, "EpisodeRunner")
+      // Only SumOfSquaresObjective and DotProductObjective are supported by the
+      // Python bindings for now
+      .def(py::init<rd::Scalar, rd::Scalar, int, int, int, int, int, int, int,
+                    unsigned int, const rd::MakeSimFunction &,
+                    const rd::SumOfSquaresObjective &,
+                    const std::shared_ptr<const rd::ValueEstimator> &,
+                    const std::shared_ptr<const rd::InputSampler> &>())
+      .def(py::init<rd::Scalar, rd::Scalar, int, int, int, int, int, int, int,
+                    unsigned int, const rd::MakeSimFunction &,
+                    const rd::DotProductObjective &,
+                    const std::shared_ptr<const rd::ValueEstimator> &,
+                    const std::shared_ptr<const rd::InputSampler> &>())
+      // The GIL is held only while entering and leaving run(); the entire
+      // episode executes in C++
+      .def("run", &rd::EpisodeRunner::run,
+           py::call_guard<py::gil_scoped_release>());
 
   py::class_<rd::SumOfSquaresObjective>(m, "SumOfSquaresObjective")
       .def(py::init<>())
-      .def("__call__", &rd::SumOfSquaresObjective::operator())
+      .def("__call__",
+           py::overload_cast<const rd::Simulation &>(
+               &rd::SumOfSquaresObjective::operator(), py::const_))
       .def_readwrite("base_vel_ref", &rd::SumOfSquaresObjective::base_vel_ref_)
       .def_readwrite("base_vel_weight",
                      &rd::SumOfSquaresObjective::base_vel_weight_)
@@ -58,7 +100,9 @@ void initOptim(py::module &m) {
 
   py::class_<rd::DotProductObjective>(m, "DotProductObjective")
       .def(py::init<>())
-      .def("__call__", &rd::DotProductObjective::operator())
+      .def("__call__",
+           py::overload_cast<const rd::Simulation &>(
+               &rd::DotProductObjective::operator(), py::const_))
       .def_readwrite("base_dir_weight",
                      &rd::DotProductObjective::base_dir_weight_)
       .def_readwrite("base_up_weight",
@@ -0,0 +1,28 @@
+#include <pybind11/pybind11.h>
+#include <robot_design/perf.h>
+
+namespace py = pybind11;
+namespace rd = robot_design;
+
+void initPerf(py::module &m) {
+  py::class_<rd::PerfPhaseStats>(m, "PerfPhaseStats")
+      .def(py::init<>())
+      .def_readonly("count", &rd::PerfPhaseStats::count_)
+      .def_readonly("total_ns", &rd::PerfPhaseStats::total_ns_)
+      .def_readonly("p50_ns", &rd::PerfPhaseStats::p50_ns_)
+      .def_readonly("p90_ns", &rd::PerfPhaseStats::p90_ns_)
+      .def_readonly("p99_ns", &rd::PerfPhaseStats::p99_ns_)
+      .def_readonly("max_ns", &rd::PerfPhaseStats::max_ns_);
+
+  // Returns a dict mapping phase name to PerfPhaseStats, aggregated across
+  // all threads since the last reset
+  m.def("get_perf_stats", []() {
+    auto stats = rd::getPerfStats();
+    py::dict result;
+    for (int p = 0; p < rd::PERF_PHASE_COUNT; ++p) {
+      result[rd::getPerfPhaseName(static_cast<rd::PerfPhase>(p))] = stats[p];
+    }
+    return result;
+  });
+  m.def("reset_perf_stats", &rd::resetPerfStats);
+}
@@ -23,4 +23,20 @@ void initProp(py::module &m) {
              std::shared_ptr<rd::HeightfieldProp>>(m, "HeightfieldProp")
       .def(py::init<rd::Scalar, const rd::Vector3 &, const rd::MatrixX &>())
       .def_readwrite("heightfield", &rd::HeightfieldProp::heightfield_);
+
+  py::class_<rd::TiledHeightfieldProp, rd::Prop,
+             std::shared_ptr<rd::TiledHeightfieldProp>>(
+      m, "TiledHeightfieldProp")
+      .def(py::init<rd::Scalar, const rd::Vector3 &, rd::MatrixX, int>(),
+           py::arg("friction"), py::arg("half_extents"),
+           py::arg("heightfield"), py::arg("tile_size") = 64)
+      // Memory-mapped variant; the file contains rows x cols column-major
+      // heights and far terrain stays on disk until a robot approaches
+      .def(py::init<rd::Scalar, const rd::Vector3 &, const std::string &,
+                    rd::Index, rd::Index, int>(),
+           py::arg("friction"), py::arg("half_extents"), py::arg("path"),
+           py::arg("rows"), py::arg("cols"), py::arg("tile_size") = 64)
+      .def_property_readonly("rows", &rd::TiledHeightfieldProp::rows)
+      .def_property_readonly("cols", &rd::TiledHeightfieldProp::cols)
+      .def_readonly("tile_size", &rd::TiledHeightfieldProp::tile_size_);
 }
@@ -1,4 +1,5 @@
 #include <pybind11/eigen.h>
+#include <pybind11/functional.h>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <robot_design/glfw_viewer.h>
@@ -62,6 +63,11 @@ void initRender(py::module &m) {
       .def(py::init<>())
       .def(py::init<bool>())
       .def("should_close", &rd::GLFWViewer::shouldClose)
+      // The GIL is released while running; pybind11 reacquires it around
+      // each step_callback invocation on the simulation thread
+      .def("run", &rd::GLFWViewer::run, py::arg("sim"),
+           py::arg("step_callback"), py::arg("real_time_factor") = 1.0,
+           py::call_guard<py::gil_scoped_release>())
       .def_readwrite("camera_params", &rd::GLFWViewer::camera_params_)
       .def_readwrite("render_params", &rd::GLFWViewer::render_params_)
       .def_readwrite("camera_controller", &rd::GLFWViewer::camera_controller_);
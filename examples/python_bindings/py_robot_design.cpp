@@ -2,22 +2,30 @@
 
 namespace py = pybind11;
 
+void initDesignSearch(py::module &m);
+void initDistributed(py::module &m);
 void initEigenGeometry(py::module &m);
 void initGraph(py::module &m);
 void initOptim(py::module &m);
+void initPerf(py::module &m);
 void initProp(py::module &m);
 void initRender(py::module &m);
 void initRobot(py::module &m);
 void initSim(py::module &m);
+void initTrajectoryLog(py::module &m);
 void initValue(py::module &m);
 
 PYBIND11_MODULE(pyrobotdesign, m) {
+  initDesignSearch(m);
+  initDistributed(m);
   initEigenGeometry(m);
   initGraph(m);
   initOptim(m);
+  initPerf(m);
   initProp(m);
   initRender(m);
   initRobot(m);
   initSim(m);
+  initTrajectoryLog(m);
   initValue(m);
 }
@@ -46,8 +46,38 @@ void initSim(py::module &m) {
       .def("restore_state", &rd::Simulation::restoreState)
       .def("step", &rd::Simulation::step);
 
-  py::class_<rd::BulletSimulation, rd::Simulation, 
+  py::class_<rd::BulletSimulationProfile>(m, "BulletSimulationProfile")
+      .def(py::init<>())
+      .def_readwrite("solver_iterations",
+                     &rd::BulletSimulationProfile::solver_iterations_)
+      .def_readwrite("substep_count",
+                     &rd::BulletSimulationProfile::substep_count_);
+
+  py::class_<rd::BulletSimulation, rd::Simulation,
              std::shared_ptr<rd::BulletSimulation>>(m, "BulletSimulation")
       .def(py::init<rd::Scalar>())
-      .def(py::init<>());
+      .def(py::init<rd::Scalar, const rd::BulletSimulationProfile &>())
+      .def(py::init<>())
+      // Returns a zero-copy view of the robot's packed state buffer; each
+      // call updates the buffer in place, and views are invalidated only
+      // when robots are added or removed (see refreshFullStateBuffer)
+      // Re-def the no-arg overloads here; pybind11 does not merge overload
+      // sets across the class hierarchy, so binding only the slot-addressed
+      // forms would shadow the base class save_state()/restore_state()
+      .def("save_state", py::overload_cast<>(&rd::BulletSimulation::saveState))
+      .def("save_state",
+           py::overload_cast<int>(&rd::BulletSimulation::saveState))
+      .def("restore_state",
+           py::overload_cast<>(&rd::BulletSimulation::restoreState))
+      .def("restore_state",
+           py::overload_cast<int>(&rd::BulletSimulation::restoreState))
+      .def("set_state_ring_size", &rd::BulletSimulation::setStateRingSize)
+      .def("get_state_ring_size", &rd::BulletSimulation::getStateRingSize)
+      .def("clone_state_into", &rd::BulletSimulation::cloneStateInto)
+      .def("refresh_full_state_buffer",
+           [](rd::BulletSimulation &sim,
+              rd::Index robot_idx) -> Eigen::Ref<rd::VectorX> {
+             return sim.refreshFullStateBuffer(robot_idx);
+           },
+           py::return_value_policy::reference_internal);
 }
@@ -0,0 +1,30 @@
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <robot_design/trajectory_log.h>
+
+namespace py = pybind11;
+namespace rd = robot_design;
+
+void initTrajectoryLog(py::module &m) {
+  m.def("compute_robot_digest", &rd::computeRobotDigest);
+
+  py::class_<rd::TrajectoryLogWriter>(m, "TrajectoryLogWriter")
+      .def(py::init<const std::string &, const rd::Simulation &, rd::Index,
+                    int>(),
+           py::arg("path"), py::arg("sim"), py::arg("robot_idx"),
+           py::arg("chunk_frame_count") = 4096)
+      .def("record_step", &rd::TrajectoryLogWriter::recordStep)
+      .def("get_frame_count", &rd::TrajectoryLogWriter::getFrameCount)
+      .def("close", &rd::TrajectoryLogWriter::close);
+
+  py::class_<rd::TrajectoryLogReader>(m, "TrajectoryLogReader")
+      .def(py::init<const std::string &>(), py::arg("path"))
+      .def("get_frame_size", &rd::TrajectoryLogReader::getFrameSize)
+      .def("get_frame_count", &rd::TrajectoryLogReader::getFrameCount)
+      .def("get_robot_digest", &rd::TrajectoryLogReader::getRobotDigest)
+      .def("get_time_step", &rd::TrajectoryLogReader::getTimeStep)
+      // Zero-copy view of the mapped file (one frame per column); valid as
+      // long as the reader is alive
+      .def("frames", &rd::TrajectoryLogReader::getFrames,
+           py::return_value_policy::reference_internal);
+}
@@ -1,6 +1,7 @@
 #include <memory>
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include <robot_design/value.h>
 #include <stdexcept>
 
@@ -18,4 +19,16 @@ void initValue(py::module &m) {
   py::class_<rd::NullValueEstimator, rd::ValueEstimator,
              std::shared_ptr<rd::NullValueEstimator>>(m, "NullValueEstimator")
       .def(py::init<>());
+
+  py::class_<rd::FusedMLPValueEstimator, rd::ValueEstimator,
+             std::shared_ptr<rd::FusedMLPValueEstimator>>(
+      m, "FusedMLPValueEstimator")
+      .def(py::init<int, const std::vector<int> &, rd::Scalar, int, int>(),
+           py::arg("obs_size"), py::arg("hidden_sizes"),
+           py::arg("learning_rate") = 1e-3, py::arg("batch_size") = 64,
+           py::arg("epoch_count") = 3)
+      .def("get_layer_count", &rd::FusedMLPValueEstimator::getLayerCount)
+      .def("set_layer_params", &rd::FusedMLPValueEstimator::setLayerParams)
+      .def("get_layer_weight", &rd::FusedMLPValueEstimator::getLayerWeight)
+      .def("get_layer_bias", &rd::FusedMLPValueEstimator::getLayerBias);
 }
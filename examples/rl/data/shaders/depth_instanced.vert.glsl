@@ -0,0 +1,12 @@
+#version 150 core
+
+in vec3 model_position;
+in mat4 instance_model_matrix;
+
+uniform mat4 proj_matrix;
+uniform mat4 view_matrix;
+
+void main() {
+  gl_Position = proj_matrix * view_matrix * instance_model_matrix *
+                vec4(model_position, 1.0);
+}